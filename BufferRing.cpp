@@ -0,0 +1,95 @@
+#include "BufferRing.hpp"
+
+#include "GLState.hpp"
+#include "gl_errors.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <cassert>
+
+BufferRing::BufferRing(GLenum target_, size_t alignment_, uint32_t regions) : target(target_), alignment(alignment_) {
+	if (alignment == 0) throw std::runtime_error("BufferRing alignment must be positive.");
+	if (regions == 0) throw std::runtime_error("BufferRing needs at least one region.");
+	fences.assign(regions, 0);
+	glGenBuffers(1, &buffer);
+	//storage is allocated by the first map()
+
+	GL_ERRORS();
+}
+
+BufferRing::~BufferRing() {
+	for (auto &f : fences) {
+		if (f) glDeleteSync(f);
+		f = 0;
+	}
+	glDeleteBuffers(1, &buffer);
+	buffer = 0;
+	gl_state.forget(); //(deleting the buffer unbinds it)
+}
+
+void *BufferRing::map(size_t size) {
+	if (size == 0) size = 1; //(mapping an empty range is an error)
+
+	if (size > region_size) {
+		//make room: regions at least double, rounded up to a multiple of alignment:
+		size_t new_size = std::max(size, 2 * region_size);
+		new_size = (new_size + alignment - 1) / alignment * alignment;
+
+		//the old store may still be in use, so just let the driver orphan it and drop the fences:
+		for (auto &f : fences) {
+			if (f) glDeleteSync(f);
+			f = 0;
+		}
+		region_size = new_size;
+		gl_state.bind_buffer(target, buffer);
+		glBufferData(target, region_size * fences.size(), nullptr, GL_STREAM_DRAW);
+		current = 0;
+	}
+
+	//wait until the GPU is done with the draws that last read this region:
+	GLsync &f = fences[current];
+	if (f) {
+		GLenum result = glClientWaitSync(f, 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED) {
+			stalls += 1;
+			do {
+				result = glClientWaitSync(f, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000); //(timeout is in nanoseconds)
+			} while (result == GL_TIMEOUT_EXPIRED);
+		}
+		if (result == GL_WAIT_FAILED) throw std::runtime_error("BufferRing: glClientWaitSync failed.");
+		glDeleteSync(f);
+		f = 0;
+	}
+
+	gl_state.bind_buffer(target, buffer);
+	void *ptr = glMapBufferRange(target, GLintptr(current * region_size), GLsizeiptr(size),
+		GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT);
+	if (!ptr) {
+		throw std::runtime_error("BufferRing: glMapBufferRange failed.");
+	}
+	mapped = size;
+	return ptr;
+}
+
+GLintptr BufferRing::unmap(size_t used) {
+	assert(used <= mapped && "can't flush more than map() mapped");
+	mapped = 0;
+	gl_state.bind_buffer(target, buffer); //(in case something else was bound since map())
+	if (used) glFlushMappedBufferRange(target, 0, GLsizeiptr(used));
+	//NOTE: glUnmapBuffer returns GL_FALSE if the store was lost (e.g., display mode change);
+	// the next frame rewrites everything, so this is only a one-frame glitch:
+	glUnmapBuffer(target);
+
+	bytes_uploaded += used;
+
+	GL_ERRORS();
+
+	return GLintptr(current * region_size);
+}
+
+void BufferRing::fence() {
+	assert(fences[current] == 0);
+	fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	current = (current + 1) % uint32_t(fences.size());
+	uses += 1;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+/*
+ * BufferRing streams per-frame data (e.g., vertices) through one OpenGL buffer
+ *  divided into several regions that are used in turn.
+ *
+ * Each use maps the next region with glMapBufferRange(unsynchronized | invalidate range),
+ *  so data is written straight into the buffer -- no staging copy and no orphaning of the store.
+ * A fence placed after the draws that read a region keeps the CPU from writing it again
+ *  while the GPU may still be reading it; waiting on that fence is counted as a stall.
+ *
+ * Usage, once per frame:
+ *   T *data = (T *)ring.map(max_bytes);   //write up to max_bytes
+ *   GLintptr offset = ring.unmap(used_bytes);
+ *   //...draw from ring.buffer at 'offset'...
+ *   ring.fence();
+ */
+
+struct BufferRing {
+	//'alignment' keeps region offsets a multiple of (e.g.) the vertex size, so offset / alignment can be used as a first vertex:
+	BufferRing(GLenum target = GL_ARRAY_BUFFER, size_t alignment = 1, uint32_t regions = 3);
+	~BufferRing();
+	BufferRing(BufferRing const &) = delete;
+	BufferRing &operator=(BufferRing const &) = delete;
+
+	//map 'size' bytes of the next region for writing:
+	// (grows the buffer if needed; waits if the GPU might still be reading the region)
+	void *map(size_t size);
+	//flush the first 'used' bytes written to the mapped region and unmap it;
+	// returns the byte offset of that data within 'buffer':
+	GLintptr unmap(size_t used);
+	//call after issuing the draws that read the region just unmapped:
+	void fence();
+
+	GLenum const target;
+	size_t const alignment;
+	GLuint buffer = 0;
+
+	size_t region_size = 0; //bytes per region (a multiple of 'alignment')
+	uint32_t current = 0; //region the next map() will use
+	size_t mapped = 0; //bytes mapped by the last map() (unmap() may flush at most this many)
+	std::vector< GLsync > fences; //one per region; 0 if that region is free
+
+	//counters (running totals; subtract earlier values to get per-frame numbers):
+	uint64_t bytes_uploaded = 0; //bytes flushed by unmap()
+	uint64_t stalls = 0; //times map() had to wait for the GPU
+	uint64_t uses = 0; //number of fence() calls
+};
@@ -0,0 +1,80 @@
+#include "ColorRectProgram.hpp"
+
+#include "gl_compile_program.hpp"
+#include "FrameUniforms.hpp"
+#include "gl_errors.hpp"
+#include "ShaderReloader.hpp"
+
+#include <iostream>
+
+GLPendingProgram ColorRectProgram::start() {
+	//Compile vertex and fragment shaders using the convenient 'gl_compile_program_async' helper function:
+	return gl_compile_program_async(
+		//vertex shader:
+		"#version 330\n"
+		FRAME_UNIFORMS_GLSL
+		"in vec2 Corner;\n"
+		"in vec2 Center;\n"
+		"in vec2 Radius;\n"
+		"in vec4 Color;\n"
+		"out vec4 color;\n"
+		"void main() {\n"
+		"	gl_Position = WORLD_TO_CLIP * vec4(Center + Corner * Radius, 0.0, 1.0);\n"
+		"	color = Color;\n"
+		"}\n"
+	,
+		//fragment shader:
+		"#version 330\n"
+		"in vec4 color;\n"
+		"out vec4 fragColor;\n"
+		"void main() {\n"
+		"	fragColor = color;\n"
+		"}\n"
+	,
+		//name (for the timing report):
+		"ColorRectProgram"
+	);
+}
+
+ColorRectProgram::ColorRectProgram(GLPendingProgram &&pending) {
+	//wait for the program to be ready (if it isn't already):
+	use(pending.get());
+
+	//when editing shaders while the game runs, rebuild this program when its files change:
+	if (ShaderReloader::current) {
+		ShaderReloader::current->watch(this, "ColorRectProgram", start, [this](GLuint rebuilt){ return use(rebuilt); });
+	}
+}
+
+ColorRectProgram::~ColorRectProgram() {
+	if (ShaderReloader::current) ShaderReloader::current->unwatch(this);
+	glDeleteProgram(program);
+	program = 0;
+}
+
+bool ColorRectProgram::use(GLuint new_program) {
+	//look up the locations of vertex attributes:
+	GLuint Corner = glGetAttribLocation(new_program, "Corner");
+	GLuint Center = glGetAttribLocation(new_program, "Center");
+	GLuint Radius = glGetAttribLocation(new_program, "Radius");
+	GLuint Color = glGetAttribLocation(new_program, "Color");
+
+	//vertex array objects were set up with the old locations, so a rebuilt program has to keep them:
+	if (program != 0 && (Corner != Corner_vec2 || Center != Center_vec2 || Radius != Radius_vec2 || Color != Color_vec4)) {
+		std::cerr << "Rebuilt ColorRectProgram moved (or dropped) an attribute; restart to use it." << std::endl;
+		return false;
+	}
+	Corner_vec2 = Corner;
+	Center_vec2 = Center;
+	Radius_vec2 = Radius;
+	Color_vec4 = Color;
+
+	//read the per-frame uniforms (WORLD_TO_CLIP, ...) from the shared block:
+	FrameUniforms::attach(new_program);
+
+	if (program != 0) glDeleteProgram(program);
+	program = new_program;
+
+	GL_ERRORS();
+	return true;
+}
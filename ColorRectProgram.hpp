@@ -0,0 +1,35 @@
+#pragma once
+
+#include "GL.hpp"
+#include "gl_compile_program.hpp"
+
+//Shader program that draws instanced, solid-colored, axis-aligned rectangles:
+// each instance is one rectangle (Center, Radius, Color); each vertex is a Corner of the unit quad [-1,1]^2.
+struct ColorRectProgram {
+	//takes a program begun with start() -- start every program that will be needed first, so they compile
+	// together, and construct afterward (e.g., PongMode::start_programs()):
+	ColorRectProgram(GLPendingProgram &&pending);
+	~ColorRectProgram();
+	ColorRectProgram(ColorRectProgram const &) = delete; //(registered with ShaderReloader by address)
+	ColorRectProgram &operator=(ColorRectProgram const &) = delete;
+
+	//begin compiling this program (see gl_compile_program_async):
+	static GLPendingProgram start();
+
+	GLuint program = 0;
+
+	//Attribute (per-vertex variable) locations:
+	GLuint Corner_vec2 = -1U;
+
+	//Attribute (per-instance variable) locations -- use glVertexAttribDivisor(..., 1):
+	GLuint Center_vec2 = -1U;
+	GLuint Radius_vec2 = -1U;
+	GLuint Color_vec4 = -1U;
+
+	//Uniforms:
+	//Frame block - WORLD_TO_CLIP and other per-frame values, shared by all programs (see FrameUniforms.hpp)
+
+	//take 'new_program' (deleting the old one) and look up its locations:
+	// returns false -- leaving everything as it was -- if a rebuilt program's attribute locations differ
+	bool use(GLuint new_program);
+};
@@ -1,21 +1,26 @@
 #include "ColorTextureProgram.hpp"
 
 #include "gl_compile_program.hpp"
+#include "FrameUniforms.hpp"
+#include "GLState.hpp"
 #include "gl_errors.hpp"
+#include "ShaderReloader.hpp"
 
-ColorTextureProgram::ColorTextureProgram() {
-	//Compile vertex and fragment shaders using the convenient 'gl_compile_program' helper function:
-	program = gl_compile_program(
+#include <iostream>
+
+GLPendingProgram ColorTextureProgram::start() {
+	//Compile vertex and fragment shaders using the convenient 'gl_compile_program_async' helper function:
+	return gl_compile_program_async(
 		//vertex shader:
 		"#version 330\n"
-		"uniform mat4 OBJECT_TO_CLIP;\n"
+		FRAME_UNIFORMS_GLSL
 		"in vec4 Position;\n"
 		"in vec4 Color;\n"
 		"in vec2 TexCoord;\n"
 		"out vec4 color;\n"
 		"out vec2 texCoord;\n"
 		"void main() {\n"
-		"	gl_Position = OBJECT_TO_CLIP * Position;\n"
+		"	gl_Position = WORLD_TO_CLIP * Position;\n"
 		"	color = Color;\n"
 		"	texCoord = TexCoord;\n"
 		"}\n"
@@ -29,28 +34,60 @@ ColorTextureProgram::ColorTextureProgram() {
 		"void main() {\n"
 		"	fragColor = texture(TEX, texCoord) * color;\n"
 		"}\n"
+	,
+		//name (for the timing report):
+		"ColorTextureProgram"
 	);
 	//As you can see above, adjacent strings in C/C++ are concatenated.
 	// this is very useful for writing long shader programs inline.
+}
 
+ColorTextureProgram::ColorTextureProgram(GLPendingProgram &&pending) {
+	//wait for the program to be ready (if it isn't already):
+	use(pending.get());
+
+	//when editing shaders while the game runs, rebuild this program when its files change:
+	if (ShaderReloader::current) {
+		ShaderReloader::current->watch(this, "ColorTextureProgram", start, [this](GLuint rebuilt){ return use(rebuilt); });
+	}
+}
+
+ColorTextureProgram::~ColorTextureProgram() {
+	if (ShaderReloader::current) ShaderReloader::current->unwatch(this);
+	glDeleteProgram(program);
+	program = 0;
+}
+
+bool ColorTextureProgram::use(GLuint new_program) {
 	//look up the locations of vertex attributes:
-	Position_vec4 = glGetAttribLocation(program, "Position");
-	Color_vec4 = glGetAttribLocation(program, "Color");
-	TexCoord_vec2 = glGetAttribLocation(program, "TexCoord");
+	GLuint Position = glGetAttribLocation(new_program, "Position");
+	GLuint Color = glGetAttribLocation(new_program, "Color");
+	GLuint TexCoord = glGetAttribLocation(new_program, "TexCoord");
+
+	//vertex array objects were set up with the old locations, so a rebuilt program has to keep them:
+	if (program != 0 && (Position != Position_vec4 || Color != Color_vec4 || TexCoord != TexCoord_vec2)) {
+		std::cerr << "Rebuilt ColorTextureProgram moved (or dropped) an attribute; restart to use it." << std::endl;
+		return false;
+	}
+	Position_vec4 = Position;
+	Color_vec4 = Color;
+	TexCoord_vec2 = TexCoord;
+
+	//read the per-frame uniforms (WORLD_TO_CLIP, ...) from the shared block:
+	FrameUniforms::attach(new_program);
 
 	//look up the locations of uniforms:
-	OBJECT_TO_CLIP_mat4 = glGetUniformLocation(program, "OBJECT_TO_CLIP");
-	GLuint TEX_sampler2D = glGetUniformLocation(program, "TEX");
+	GLuint TEX_sampler2D = glGetUniformLocation(new_program, "TEX");
 
 	//set TEX to always refer to texture binding zero:
-	glUseProgram(program); //bind program -- glUniform* calls refer to this program now
+	gl_state.use_program(new_program); //bind program -- glUniform* calls refer to this program now
 
 	glUniform1i(TEX_sampler2D, 0); //set TEX to sample from GL_TEXTURE0
+	//(left bound: whatever draws next binds what it needs, through gl_state)
 
-	glUseProgram(0); //unbind program -- glUniform* calls refer to ??? now
-}
+	if (program != 0) glDeleteProgram(program);
+	program = new_program;
 
-ColorTextureProgram::~ColorTextureProgram() {
-	glDeleteProgram(program);
-	program = 0;
+	GL_ERRORS();
+	return true;
 }
@@ -1,11 +1,19 @@
 #pragma once
 
 #include "GL.hpp"
+#include "gl_compile_program.hpp"
 
 //Shader program that draws transformed, textured vertices tinted with vertex colors:
 struct ColorTextureProgram {
-	ColorTextureProgram();
+	//takes a program begun with start() -- start every program that will be needed first, so they compile
+	// together, and construct afterward (e.g., PongMode::start_programs()):
+	ColorTextureProgram(GLPendingProgram &&pending);
 	~ColorTextureProgram();
+	ColorTextureProgram(ColorTextureProgram const &) = delete; //(registered with ShaderReloader by address)
+	ColorTextureProgram &operator=(ColorTextureProgram const &) = delete;
+
+	//begin compiling this program (see gl_compile_program_async):
+	static GLPendingProgram start();
 
 	GLuint program = 0;
 
@@ -14,9 +22,13 @@ struct ColorTextureProgram {
 	GLuint Color_vec4 = -1U;
 	GLuint TexCoord_vec2 = -1U;
 
-	//Uniform (per-invocation variable) locations:
-	GLuint OBJECT_TO_CLIP_mat4 = -1U;
+	//Uniforms:
+	//Frame block - WORLD_TO_CLIP and other per-frame values, shared by all programs (see FrameUniforms.hpp)
 
 	//Textures:
 	//TEXTURE0 - texture that is accessed by TexCoord
+
+	//take 'new_program' (deleting the old one) and look up its locations:
+	// returns false -- leaving everything as it was -- if a rebuilt program's attribute locations differ
+	bool use(GLuint new_program);
 };
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cassert>
+#include <utility>
+#include <stdint.h>
+
+/*
+ * FixedRing is a first-in-first-out queue with room for 'Capacity' elements stored inline,
+ *  so pushing and popping never allocate (unlike std::deque, which allocates and frees blocks as it goes).
+ *
+ * Element 0 is the oldest. When the ring is full, push_back() drops the oldest element to make room.
+ */
+
+template< typename T, uint32_t Capacity >
+struct FixedRing {
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "FixedRing capacity must be a power of two");
+
+	uint32_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	bool full() const { return count == Capacity; }
+
+	T &operator[](uint32_t i) { assert(i < count); return items[(first + i) & (Capacity - 1)]; }
+	T const &operator[](uint32_t i) const { assert(i < count); return items[(first + i) & (Capacity - 1)]; }
+	T &front() { return (*this)[0]; }
+	T &back() { return (*this)[count - 1]; }
+
+	template< typename... Args >
+	void emplace_back(Args&&... args) {
+		if (full()) pop_front();
+		items[(first + count) & (Capacity - 1)] = T(std::forward< Args >(args)...);
+		count += 1;
+	}
+
+	void pop_front() {
+		assert(count > 0);
+		first = (first + 1) & (Capacity - 1);
+		count -= 1;
+	}
+
+	void clear() {
+		first = 0;
+		count = 0;
+	}
+
+	T items[Capacity];
+	uint32_t first = 0; //index in 'items' of element 0
+	uint32_t count = 0;
+};
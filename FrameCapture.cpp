@@ -0,0 +1,269 @@
+#include "FrameCapture.hpp"
+
+#include "gl_errors.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <cassert>
+
+FrameCapture::FrameCapture(uint32_t count) {
+	if (count == 0) {
+		count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+	}
+	//enough readbacks to keep every writer busy with one waiting, plus a couple still on their way from the GPU:
+	max_in_flight = count + 2;
+	//(the writers themselves are started by the first read(), so a game that never captures never starts them)
+	writer_count = count;
+}
+
+FrameCapture::~FrameCapture() {
+	if (capturing()) stop_capture();
+
+	//everything requested still gets saved:
+	while (!readbacks.empty()) {
+		advance(true);
+	}
+
+	{ //let the writers finish encoding and exit:
+		std::unique_lock< std::mutex > lock(mutex);
+		quit = true;
+	}
+	cv.notify_all();
+	for (auto &writer : writers) {
+		writer.join();
+	}
+
+	glDeleteBuffers(GLsizei(free_buffers.size()), free_buffers.data());
+	free_buffers.clear();
+	free_buffer_sizes.clear();
+}
+
+void FrameCapture::request(std::string const &filename, glm::uvec2 const &size) {
+	assert(filename != "");
+	read(size, filename, PNGEncoding(), 0);
+}
+
+void FrameCapture::start_capture(std::string const &target, Format format, uint32_t every) {
+	if (capturing()) stop_capture();
+	if (every == 0) throw std::runtime_error("Capture interval must be at least one frame.");
+
+	if (format == RawRGBA) {
+		//(no writer touches 'raw' while no raw frames are outstanding, which is the case between captures)
+		raw.open(target, std::ios::binary);
+		if (!raw) throw std::runtime_error("Failed to open '" + target + "' for writing frames.");
+	}
+
+	capture_every = every;
+	capture_target = target;
+	capture_format = format;
+	capture_size = glm::uvec2(0);
+	capture_frames_seen = 0;
+	capture_frames_read = 0;
+	stalls = 0;
+	std::cout << "Capturing every " << (every == 1 ? std::string("") : std::to_string(every) + "th ") << "frame to '" << target << "'"
+		<< (format == RawRGBA ? " (raw RGBA)" : "") << "." << std::endl;
+}
+
+void FrameCapture::stop_capture() {
+	assert(capturing());
+	if (capture_format == RawRGBA) {
+		//raw frames share the stream, so they must all be written before it closes:
+		while (!readbacks.empty()) {
+			advance(true);
+		}
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			cv.wait(lock, [this](){ return raw_next == capture_frames_read; });
+		}
+		raw.close();
+		raw_next = 0;
+	}
+	std::cout << "Captured " << capture_frames_read << " frames";
+	if (capture_format == RawRGBA) std::cout << " of " << capture_size.x << "x" << capture_size.y;
+	std::cout << " to '" << capture_target << "'; the game waited on capture " << stalls << " times." << std::endl;
+	capture_every = 0;
+}
+
+void FrameCapture::capture_frame(glm::uvec2 const &size) {
+	if (!capturing()) return;
+	uint64_t frame = capture_frames_seen++;
+	if (frame % capture_every != 0) return;
+
+	if (capture_format == RawRGBA) {
+		if (capture_size == glm::uvec2(0)) capture_size = size;
+		if (size != capture_size) {
+			std::cerr << "Window size changed during raw capture; stopping capture." << std::endl;
+			stop_capture();
+			return;
+		}
+		read(size, "", capture_encoding, capture_frames_read);
+	} else {
+		std::ostringstream filename;
+		filename << capture_target << std::setw(6) << std::setfill('0') << capture_frames_read << ".png";
+		read(size, filename.str(), capture_encoding, 0);
+	}
+	capture_frames_read += 1;
+}
+
+void FrameCapture::read(glm::uvec2 const &size, std::string const &filename, PNGEncoding const &encoding, uint64_t raw_frame) {
+	if (writers.empty()) {
+		writers.reserve(writer_count);
+		for (uint32_t i = 0; i < writer_count; ++i) {
+			writers.emplace_back(&FrameCapture::write_loop, this);
+		}
+	}
+
+	//bounded: wait for the oldest readback rather than pile up more (or drop this one):
+	while (readbacks.size() >= max_in_flight) {
+		stalls += 1;
+		advance(true);
+	}
+
+	size_t bytes = size_t(size.x) * size_t(size.y) * 4;
+
+	readbacks.emplace_back();
+	Readback &readback = readbacks.back();
+	readback.size = size;
+	readback.filename = filename;
+	readback.encoding = encoding;
+	readback.raw_frame = raw_frame;
+
+	//reuse a free buffer if one is big enough:
+	size_t have = 0;
+	for (uint32_t i = 0; i < free_buffers.size(); ++i) {
+		if (free_buffer_sizes[i] >= bytes) {
+			readback.buffer = free_buffers[i];
+			have = free_buffer_sizes[i];
+			free_buffers.erase(free_buffers.begin() + i);
+			free_buffer_sizes.erase(free_buffer_sizes.begin() + i);
+			break;
+		}
+	}
+	if (readback.buffer == 0) glGenBuffers(1, &readback.buffer);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+	if (have < bytes) {
+		glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+		have = bytes;
+	}
+	//with a pack buffer bound, this just queues a copy into the buffer (nothing waits):
+	glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid *)0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readback.buffer_size = have;
+
+	GL_ERRORS();
+}
+
+void FrameCapture::poll() {
+	while (!readbacks.empty() && advance(false)) {
+	}
+}
+
+bool FrameCapture::advance(bool block) {
+	assert(!readbacks.empty());
+
+	//hand every readback that has arrived to the writers (they arrive in order, so stop at the first that hasn't):
+	for (auto &readback : readbacks) {
+		if (readback.mapped) continue;
+		assert(readback.fence);
+		bool wait = block && &readback == &readbacks.front(); //(only the oldest is worth waiting for)
+		GLenum result = glClientWaitSync(readback.fence, (wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0), 0);
+		while (wait && result == GL_TIMEOUT_EXPIRED) {
+			result = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ULL); //1 second
+		}
+		if (result == GL_TIMEOUT_EXPIRED) break;
+		if (result == GL_WAIT_FAILED) throw std::runtime_error("Failed to wait for frame readback.");
+		glDeleteSync(readback.fence);
+		readback.fence = 0;
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+		void const *mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size_t(readback.size.x) * size_t(readback.size.y) * 4, GL_MAP_READ_BIT);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		if (!mapped) throw std::runtime_error("Failed to map frame readback buffer.");
+
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			readback.mapped = mapped;
+			jobs.emplace_back(&readback);
+		}
+		cv.notify_all();
+	}
+
+	//once the writers are done with the oldest readback, its buffer can be unmapped and reused:
+	Readback &oldest = readbacks.front();
+	if (!oldest.mapped) return false;
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		if (block) cv.wait(lock, [&oldest](){ return oldest.copied; });
+		if (!oldest.copied) return false;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, oldest.buffer);
+	glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	free_buffers.emplace_back(oldest.buffer);
+	free_buffer_sizes.emplace_back(oldest.buffer_size);
+	readbacks.pop_front();
+
+	GL_ERRORS();
+	return true;
+}
+
+void FrameCapture::write_loop() {
+	std::vector< glm::u8vec4 > pixels; //(reused from frame to frame)
+	while (true) {
+		Readback *job;
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			cv.wait(lock, [this](){ return quit || !jobs.empty(); });
+			if (jobs.empty()) return; //(quit, and nothing left to write)
+			job = jobs.front();
+			jobs.pop_front();
+		}
+
+		glm::u8vec4 const *mapped = reinterpret_cast< glm::u8vec4 const * >(job->mapped);
+		glm::uvec2 size = job->size;
+
+		if (job->filename == "") {
+			//raw stream: wait for this frame's turn, then write it straight from the mapping, flipped to top-to-bottom rows:
+			uint64_t frame = job->raw_frame;
+			std::unique_lock< std::mutex > lock(mutex);
+			cv.wait(lock, [this,frame](){ return raw_next == frame; });
+			lock.unlock();
+			for (uint32_t row = size.y; row > 0; --row) {
+				raw.write(reinterpret_cast< char const * >(mapped + size_t(row - 1) * size.x), size.x * 4);
+			}
+			if (!raw) std::cerr << "Failed to write frame " << frame << " of raw capture." << std::endl;
+			lock.lock();
+			raw_next += 1;
+			job->copied = true;
+			lock.unlock();
+			cv.notify_all();
+			continue;
+		}
+
+		//copy out of the mapped buffer (the framebuffer's alpha isn't meaningful, so make it opaque):
+		std::string filename = job->filename;
+		PNGEncoding encoding = job->encoding;
+		pixels.assign(mapped, mapped + size_t(size.x) * size_t(size.y));
+		for (auto &px : pixels) {
+			px.a = 0xff;
+		}
+
+		//done with the mapping ('job' may be gone as soon as this is set):
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			job->copied = true;
+		}
+		cv.notify_all();
+
+		try {
+			save_png(filename, size, pixels.data(), LowerLeftOrigin, encoding);
+		} catch (std::exception const &e) {
+			std::cerr << "Failed to save '" << filename << "': " << e.what() << std::endl;
+		}
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "GL.hpp"
+#include "load_save_png.hpp"
+
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * FrameCapture saves screenshots -- or every frame, for recordings -- without stalling the frame:
+ *  - request() / capture_frame() start an asynchronous glReadPixels into a pixel pack buffer and drop a fence after it;
+ *  - poll() (once per frame) maps buffers whose fence has passed -- usually a frame or two later --
+ *    and hands the mappings to a pool of writer threads;
+ *  - a writer copies the pixels out (so the buffer can be unmapped and reused) and encodes a PNG,
+ *    or, for a raw stream, writes the frame straight from the mapping, in frame order.
+ * So the render thread only issues GL commands; readback waits, copying, and compression all happen elsewhere.
+ *
+ * Pack buffers are pooled, and at most 'max_in_flight' readbacks are outstanding; past that, the render
+ *  thread waits for the oldest (counted in 'stalls'), so a capture slows the game down rather than dropping frames.
+ *
+ * Needs a current OpenGL context for its whole lifetime. The destructor finishes (and saves) everything requested.
+ */
+
+struct FrameCapture {
+	//'writers' threads (0 = one per core, leaving one for the game), started on the first screenshot or captured frame:
+	FrameCapture(uint32_t writers = 0);
+	~FrameCapture();
+	FrameCapture(FrameCapture const &) = delete;
+	FrameCapture &operator=(FrameCapture const &) = delete;
+
+	//read 'size' pixels from the lower left of the currently-bound read buffer, to be saved to 'filename':
+	void request(std::string const &filename, glm::uvec2 const &size);
+	//call once per frame to move requests along:
+	void poll();
+
+	//----- continuous capture -----
+
+	enum Format {
+		PNGSequence, //<target>000000.png, <target>000001.png, ...
+		RawRGBA, //frames appended to the file <target> as top-to-bottom RGBA rows
+		         // (e.g., make <target> a named pipe into 'ffmpeg -f rawvideo -pix_fmt rgba -s WxH -r 60 -i <target> ...')
+	};
+	//how frames of a PNG sequence are compressed:
+	// (fast, and one frame per writer thread rather than splitting each frame up, since many are in flight at once)
+	PNGEncoding capture_encoding{1, PNGFilterUp, false};
+	//start capturing every 'every'th frame passed to capture_frame() (throws if a raw file can't be opened):
+	void start_capture(std::string const &target, Format format, uint32_t every = 1);
+	//stop capturing (frames already read back are still written) and print a summary:
+	void stop_capture();
+	bool capturing() const { return capture_every != 0; }
+	//call once per frame, after drawing, with the read buffer set to what should be captured:
+	void capture_frame(glm::uvec2 const &size);
+
+	//----- internals -----
+
+	//one readback, from being read until its buffer is unmapped:
+	struct Readback {
+		GLuint buffer = 0; //pixel pack buffer
+		size_t buffer_size = 0; //bytes in its store (may be more than this readback needs)
+		GLsync fence = 0; //passed once the pixels are in 'buffer'
+		glm::uvec2 size = glm::uvec2(0);
+		std::string filename; //PNG to write, or "" for a frame of the raw stream
+		PNGEncoding encoding; //how to write it
+		uint64_t raw_frame = 0; //position in the raw stream
+		void const *mapped = nullptr; //non-null once handed to the writers
+		bool copied = false; //set by a writer once it is done with 'mapped' (guarded by 'mutex')
+	};
+	std::deque< Readback > readbacks; //oldest first (render thread only, except 'copied')
+	uint32_t max_in_flight = 0;
+	std::vector< GLuint > free_buffers; //pack buffers ready for reuse, with their sizes
+	std::vector< size_t > free_buffer_sizes;
+
+	void read(glm::uvec2 const &size, std::string const &filename, PNGEncoding const &encoding, uint64_t raw_frame);
+	//map and hand off readbacks that have arrived, then recycle the oldest if the writers are done with it
+	// ('block' waits until the oldest can be recycled; otherwise just checks):
+	bool advance(bool block);
+
+	//capture state (render thread):
+	uint32_t capture_every = 0; //0 when not capturing
+	std::string capture_target;
+	Format capture_format = PNGSequence;
+	glm::uvec2 capture_size = glm::uvec2(0); //(raw frames must all be the same size)
+	uint64_t capture_frames_seen = 0;
+	uint64_t capture_frames_read = 0;
+	uint64_t stalls = 0; //times the render thread had to wait for readbacks to finish
+
+	//writer threads (none until the first read()):
+	void write_loop();
+	uint32_t writer_count = 0;
+	std::vector< std::thread > writers;
+	std::mutex mutex;
+	std::condition_variable cv; //signalled when 'jobs' gets work, 'copied' is set, or 'raw_next' moves
+	std::deque< Readback * > jobs; //readbacks mapped and waiting for a writer
+	std::ofstream raw; //raw stream being written (guarded by 'mutex' being this frame's turn)
+	uint64_t raw_next = 0; //raw stream frame to be written next
+	bool quit = false;
+};
@@ -0,0 +1,199 @@
+#include "FrameStats.hpp"
+
+#include "gl_errors.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+#include <cassert>
+
+char const *FrameStats::phase_name(uint32_t phase) {
+	static char const *names[PhaseCount] = { "events", "update", "draw", "swap", "draw (gpu)" };
+	assert(phase < PhaseCount);
+	return names[phase];
+}
+
+static void clear_sample(FrameStats::Sample &sample) {
+	for (uint32_t p = 0; p < FrameStats::PhaseCount; ++p) {
+		sample.start[p] = 0.0;
+		sample.ms[p] = -1.0f;
+	}
+}
+
+FrameStats::FrameStats() {
+	history.resize(History);
+	scratch.reserve(Window);
+	clear_sample(history[0]);
+	epoch = Clock::now();
+
+	glGenQueries(Queries, begin_queries);
+	glGenQueries(Queries, end_queries);
+	sync_gpu_clock();
+
+	GL_ERRORS();
+}
+
+FrameStats::~FrameStats() {
+	glDeleteQueries(Queries, begin_queries);
+	glDeleteQueries(Queries, end_queries);
+}
+
+void FrameStats::sync_gpu_clock() {
+	//GL_TIMESTAMP read this way is the GPU clock "now" (it doesn't wait for queued commands), so the two clocks line up here:
+	GLint64 gpu_ns = 0;
+	glGetInteger64v(GL_TIMESTAMP, &gpu_ns);
+	double cpu_us = std::chrono::duration< double, std::micro >(Clock::now() - epoch).count();
+	gpu_to_epoch = cpu_us - double(gpu_ns) * 1.0e-3;
+}
+
+void FrameStats::begin(Phase phase) {
+	assert(phase < DrawGPU);
+	began[phase] = Clock::now();
+}
+
+void FrameStats::end(Phase phase) {
+	assert(phase < DrawGPU);
+	auto now = Clock::now();
+	Sample &sample = history[frame % History];
+	sample.start[phase] = std::chrono::duration< double, std::micro >(began[phase] - epoch).count();
+	sample.ms[phase] = std::chrono::duration< float, std::milli >(now - began[phase]).count();
+}
+
+void FrameStats::begin_gpu() {
+	assert(!gpu_timing);
+	if (query_pending[next_query]) return; //GPU is far behind; skip this frame rather than wait
+	glQueryCounter(begin_queries[next_query], GL_TIMESTAMP);
+	gpu_timing = true;
+}
+
+void FrameStats::end_gpu() {
+	if (!gpu_timing) return;
+	glQueryCounter(end_queries[next_query], GL_TIMESTAMP);
+	query_frame[next_query] = frame;
+	query_pending[next_query] = true;
+	next_query = (next_query + 1) % Queries;
+	gpu_timing = false;
+}
+
+void FrameStats::end_frame() {
+	assert(!gpu_timing && "end_gpu() must be called before end_frame()");
+
+	//collect any GPU times that have come in, oldest first (queries finish in order, so stop at the first one that hasn't):
+	for (uint32_t i = 0; i < Queries; ++i) {
+		uint32_t q = (next_query + i) % Queries;
+		if (!query_pending[q]) continue;
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv(end_queries[q], GL_QUERY_RESULT_AVAILABLE, &available); //(the end timestamp comes in last)
+		if (!available) break;
+		GLuint64 begin_ns = 0, end_ns = 0;
+		glGetQueryObjectui64v(begin_queries[q], GL_QUERY_RESULT, &begin_ns);
+		glGetQueryObjectui64v(end_queries[q], GL_QUERY_RESULT, &end_ns);
+		query_pending[q] = false;
+		if (frame - query_frame[q] < History) {
+			Sample &sample = history[query_frame[q] % History];
+			sample.start[DrawGPU] = double(begin_ns) * 1.0e-3 + gpu_to_epoch;
+			sample.ms[DrawGPU] = float(double(end_ns - begin_ns) * 1.0e-6);
+		}
+	}
+
+	//the two clocks can drift apart, so line them up again now and then:
+	if ((frame + 1) % Window == 0) sync_gpu_clock();
+
+	frame += 1;
+	clear_sample(history[frame % History]);
+}
+
+FrameStats::Percentiles FrameStats::percentiles(Phase phase) {
+	assert(phase < PhaseCount);
+
+	//times from the last Window finished frames:
+	scratch.clear();
+	uint64_t first = (frame > Window ? frame - Window : 0);
+	for (uint64_t f = first; f < frame; ++f) {
+		float ms = history[f % History].ms[phase];
+		if (ms >= 0.0f) scratch.emplace_back(ms);
+	}
+
+	Percentiles ret;
+	ret.count = uint32_t(scratch.size());
+	if (scratch.empty()) return ret;
+
+	//nearest-rank percentile; nth_element partially sorts, so later (higher) ranks can start after earlier ones:
+	auto rank = [&](float p) {
+		return std::min(scratch.size() - 1, size_t(p * scratch.size()));
+	};
+	size_t r50 = rank(0.50f), r95 = rank(0.95f), r99 = rank(0.99f);
+	std::nth_element(scratch.begin(), scratch.begin() + r50, scratch.end());
+	std::nth_element(scratch.begin() + r50, scratch.begin() + r95, scratch.end());
+	std::nth_element(scratch.begin() + r95, scratch.begin() + r99, scratch.end());
+	ret.p50 = scratch[r50];
+	ret.p95 = scratch[r95];
+	ret.p99 = scratch[r99];
+	return ret;
+}
+
+void FrameStats::print(std::ostream &out) {
+	out << "frame times (ms, last " << std::min< uint64_t >(frame, Window) << " frames):\n";
+	for (uint32_t p = 0; p < PhaseCount; ++p) {
+		Percentiles pc = percentiles(Phase(p));
+		out << "  " << std::setw(11) << std::left << phase_name(p) << std::right;
+		if (pc.count == 0) {
+			out << " (untimed)\n";
+		} else {
+			out << std::fixed << std::setprecision(3)
+				<< " p50 " << pc.p50 << "  p95 " << pc.p95 << "  p99 " << pc.p99 << "\n";
+			out.unsetf(std::ios::floatfield);
+		}
+	}
+	out.flush();
+}
+
+void FrameStats::write_csv(std::string const &filename) const {
+	std::ofstream out(filename, std::ios::binary);
+	if (!out) throw std::runtime_error("Failed to open '" + filename + "' for writing.");
+
+	out << "frame";
+	for (uint32_t p = 0; p < PhaseCount; ++p) {
+		out << "," << phase_name(p) << " (ms)";
+	}
+	out << "\n";
+
+	uint64_t first = (frame > History ? frame - History : 0);
+	for (uint64_t f = first; f < frame; ++f) {
+		Sample const &sample = history[f % History];
+		out << f;
+		for (uint32_t p = 0; p < PhaseCount; ++p) {
+			out << ",";
+			if (sample.ms[p] >= 0.0f) out << sample.ms[p];
+		}
+		out << "\n";
+	}
+
+	if (!out) throw std::runtime_error("Failed to write '" + filename + "'.");
+}
+
+void FrameStats::write_trace(std::string const &filename) const {
+	std::ofstream out(filename, std::ios::binary);
+	if (!out) throw std::runtime_error("Failed to open '" + filename + "' for writing.");
+
+	out << std::fixed << std::setprecision(3);
+	out << "{\"traceEvents\":[\n";
+	out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"cpu\"}},\n";
+	out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"gpu\"}}";
+
+	uint64_t first = (frame > History ? frame - History : 0);
+	for (uint64_t f = first; f < frame; ++f) {
+		Sample const &sample = history[f % History];
+		for (uint32_t p = 0; p < PhaseCount; ++p) {
+			if (sample.ms[p] < 0.0f) continue;
+			out << ",\n{\"name\":\"" << phase_name(p) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << (p == DrawGPU ? 2 : 1)
+				<< ",\"ts\":" << sample.start[p] << ",\"dur\":" << double(sample.ms[p]) * 1000.0
+				<< ",\"args\":{\"frame\":" << f << "}}";
+		}
+	}
+	out << "\n]}\n";
+
+	if (!out) throw std::runtime_error("Failed to write '" + filename + "'.");
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <chrono>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/*
+ * FrameStats times the phases of each frame of the main loop:
+ *  CPU time of event handling, update, draw, and buffer swap (with Scope timers), and
+ *  GPU time of draw (with GL_TIMESTAMP queries before and after it, read back a few frames later so nothing waits on the GPU).
+ *
+ * GPU timestamps are moved onto the CPU clock with an offset measured (with glGetInteger64v(GL_TIMESTAMP))
+ *  at startup and again every 'Window' frames, so the trace shows when the GPU actually ran each draw --
+ *  i.e., how far behind the CPU's submission it was.
+ *
+ * Percentiles (p50/p95/p99) cover the last 'Window' frames;
+ *  the last 'History' frames can be written out as CSV or as Chrome trace JSON (load in chrome://tracing or ui.perfetto.dev).
+ * All storage is allocated up front, so recording never touches the heap.
+ *
+ * Needs a current OpenGL context for its whole lifetime (for the queries).
+ */
+
+struct FrameStats {
+	enum Phase : uint32_t {
+		Events,
+		Update,
+		Draw,
+		Swap,
+		DrawGPU, //GPU time of draw
+		PhaseCount
+	};
+	static char const *phase_name(uint32_t phase);
+
+	static constexpr uint32_t History = 16384; //frames kept for write_csv / write_trace
+	static constexpr uint32_t Window = 256; //frames covered by percentiles()
+	static constexpr uint32_t Queries = 4; //GPU timings (pairs of timestamp queries) in flight
+
+	FrameStats();
+	~FrameStats();
+	FrameStats(FrameStats const &) = delete;
+	FrameStats &operator=(FrameStats const &) = delete;
+
+	//times a CPU phase of the current frame from construction to destruction:
+	struct Scope {
+		Scope(FrameStats &stats_, Phase phase_) : stats(stats_), phase(phase_) { stats.begin(phase); }
+		~Scope() { stats.end(phase); }
+		FrameStats &stats;
+		Phase phase;
+	};
+	void begin(Phase phase);
+	void end(Phase phase);
+
+	//bracket the draw calls with these to time them on the GPU:
+	// (if every query is still in flight the frame just goes untimed)
+	void begin_gpu();
+	void end_gpu();
+
+	//call once all phases of a frame are done; picks up finished GPU timings and starts the next frame:
+	void end_frame();
+
+	struct Percentiles {
+		float p50 = 0.0f, p95 = 0.0f, p99 = 0.0f; //milliseconds
+		uint32_t count = 0; //frames that had a time for the phase
+	};
+	Percentiles percentiles(Phase phase);
+
+	//one line per phase with its percentiles:
+	void print(std::ostream &out);
+
+	//write the recorded frames (throws on error):
+	// CSV: one row per frame, milliseconds per phase (empty if untimed)
+	// trace: one complete ("X") event per phase per frame; GPU times are drawn on their own track, at the time the GPU ran them
+	void write_csv(std::string const &filename) const;
+	void write_trace(std::string const &filename) const;
+
+	//----- internals -----
+
+	typedef std::chrono::high_resolution_clock Clock;
+
+	struct Sample {
+		double start[PhaseCount]; //microseconds since 'epoch'
+		float ms[PhaseCount]; //negative if the phase was not timed
+	};
+	std::vector< Sample > history; //frame f is history[f % History]
+	uint64_t frame = 0; //frame being recorded
+
+	Clock::time_point epoch;
+	Clock::time_point began[PhaseCount];
+
+	GLuint begin_queries[Queries] = { }, end_queries[Queries] = { }; //GL_TIMESTAMP before / after the draw
+	uint64_t query_frame[Queries] = { }; //frame each pair timed
+	bool query_pending[Queries] = { };
+	uint32_t next_query = 0;
+	bool gpu_timing = false; //has begin_gpu() issued a timestamp in this frame?
+
+	double gpu_to_epoch = 0.0; //microseconds to add to a GPU timestamp (converted to microseconds) to get time since 'epoch'
+	void sync_gpu_clock(); //(re)measure gpu_to_epoch
+
+	std::vector< float > scratch; //for percentiles()
+};
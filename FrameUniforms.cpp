@@ -0,0 +1,38 @@
+#include "FrameUniforms.hpp"
+
+#include "GLState.hpp"
+#include "gl_errors.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+//uniform buffer ranges must start at multiples of this:
+static size_t uniform_buffer_alignment() {
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	return size_t(std::max(alignment, 1));
+}
+
+FrameUniforms::FrameUniforms() : ring(GL_UNIFORM_BUFFER, uniform_buffer_alignment()) {
+}
+
+void FrameUniforms::set(Data const &data) {
+	std::memcpy(ring.map(sizeof(Data)), &data, sizeof(Data));
+	GLintptr offset = ring.unmap(sizeof(Data));
+
+	//bound once here, for every program that reads the block:
+	gl_state.bind_buffer_range(GL_UNIFORM_BUFFER, Binding, ring.buffer, offset, sizeof(Data));
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
+
+void FrameUniforms::fence() {
+	ring.fence();
+}
+
+void FrameUniforms::attach(GLuint program) {
+	GLuint index = glGetUniformBlockIndex(program, "Frame");
+	if (index != GL_INVALID_INDEX) {
+		glUniformBlockBinding(program, index, Binding);
+	}
+}
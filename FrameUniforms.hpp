@@ -0,0 +1,56 @@
+#pragma once
+
+#include "BufferRing.hpp"
+
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+/*
+ * FrameUniforms holds values every shader program needs each frame (the world-to-clip transform, time, ...)
+ *  in one uniform buffer block, so they are uploaded once per frame instead of once per program.
+ *
+ * Programs declare the block by including FRAME_UNIFORMS_GLSL in their shader source and, after linking,
+ *  connect it with FrameUniforms::attach(program). Each frame, set() writes the values to the next region
+ *  of a BufferRing and binds that region to FrameUniforms::Binding, where every attached program reads it.
+ *
+ * Usage, once per frame:
+ *   frame_uniforms.set(data);
+ *   //...draw with any attached programs...
+ *   frame_uniforms.fence();
+ */
+
+//GLSL declaration of the block (adjacent string literals, to paste into shader source):
+#define FRAME_UNIFORMS_GLSL \
+	"layout(std140) uniform Frame {\n" \
+	"	mat4 WORLD_TO_CLIP;\n" \
+	"	vec2 DRAWABLE_SIZE;\n" \
+	"	float TIME;\n" \
+	"};\n"
+
+struct FrameUniforms {
+	FrameUniforms();
+
+	//the block's contents, laid out by std140 rules:
+	struct Data {
+		glm::mat4 WORLD_TO_CLIP = glm::mat4(1.0f); //world (e.g., court) coordinates to clip coordinates
+		glm::vec2 DRAWABLE_SIZE = glm::vec2(0.0f); //in pixels
+		float TIME = 0.0f; //seconds; what counts as zero is up to whoever calls set()
+		float _pad = 0.0f; //(std140 rounds blocks up to a multiple of 16 bytes)
+	};
+	static_assert(sizeof(Data) == 4*16 + 4*2 + 4 + 4, "FrameUniforms::Data should match the std140 layout");
+
+	//upload 'data' and bind it for the draws that follow:
+	void set(Data const &data);
+	//call after issuing the draws that read the data from the last set():
+	void fence();
+
+	//uniform buffer binding point that the block is read from:
+	static constexpr GLuint Binding = 0;
+
+	//connect 'program's Frame block (if it uses one) to Binding:
+	static void attach(GLuint program);
+
+	//----- internals -----
+	BufferRing ring; //(regions aligned to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT)
+};
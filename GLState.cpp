@@ -0,0 +1,125 @@
+#include "GLState.hpp"
+
+GLState gl_state;
+
+void GLState::use_program(GLuint program_) {
+	if (program_ == program) {
+		skipped += 1;
+		return;
+	}
+	glUseProgram(program_);
+	program = program_;
+	issued += 1;
+	binds += 1;
+}
+
+void GLState::bind_vertex_array(GLuint array) {
+	if (array == vertex_array) {
+		skipped += 1;
+		return;
+	}
+	glBindVertexArray(array);
+	vertex_array = array;
+	issued += 1;
+	binds += 1;
+}
+
+void GLState::bind_buffer(GLenum target, GLuint buffer) {
+	GLuint *shadow = nullptr;
+	if (target == GL_ARRAY_BUFFER) shadow = &array_buffer;
+	else if (target == GL_UNIFORM_BUFFER) shadow = &uniform_buffer;
+	//(GL_ELEMENT_ARRAY_BUFFER is part of the vertex array's state, so it -- like other targets -- isn't tracked)
+
+	if (shadow && *shadow == buffer) {
+		skipped += 1;
+		return;
+	}
+	glBindBuffer(target, buffer);
+	if (shadow) *shadow = buffer;
+	issued += 1;
+	binds += 1;
+}
+
+void GLState::bind_buffer_range(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+	//(indexed bindings usually change every frame, e.g., to a new region of a BufferRing, so they aren't shadowed)
+	glBindBufferRange(target, index, buffer, offset, size);
+	if (target == GL_UNIFORM_BUFFER) uniform_buffer = buffer;
+	issued += 1;
+	binds += 1;
+}
+
+void GLState::active_texture(GLenum unit_) {
+	if (unit_ == unit) {
+		skipped += 1;
+		return;
+	}
+	glActiveTexture(unit_);
+	unit = unit_;
+	issued += 1;
+}
+
+void GLState::bind_texture(GLenum target, GLuint texture) {
+	GLuint *shadow = nullptr;
+	if (target == GL_TEXTURE_2D && unit != Unknown && unit - GL_TEXTURE0 < Units) shadow = &texture_2d[unit - GL_TEXTURE0];
+
+	if (shadow && *shadow == texture) {
+		skipped += 1;
+		return;
+	}
+	glBindTexture(target, texture);
+	if (shadow) *shadow = texture;
+	issued += 1;
+	binds += 1;
+}
+
+int8_t *GLState::capability_state(GLenum capability) {
+	if (capability == GL_BLEND) return &blend;
+	if (capability == GL_DEPTH_TEST) return &depth_test;
+	if (capability == GL_CULL_FACE) return &cull_face;
+	if (capability == GL_SCISSOR_TEST) return &scissor_test;
+	return nullptr;
+}
+
+void GLState::enable(GLenum capability) {
+	int8_t *shadow = capability_state(capability);
+	if (shadow && *shadow == On) {
+		skipped += 1;
+		return;
+	}
+	glEnable(capability);
+	if (shadow) *shadow = On;
+	issued += 1;
+}
+
+void GLState::disable(GLenum capability) {
+	int8_t *shadow = capability_state(capability);
+	if (shadow && *shadow == Off) {
+		skipped += 1;
+		return;
+	}
+	glDisable(capability);
+	if (shadow) *shadow = Off;
+	issued += 1;
+}
+
+void GLState::blend_func(GLenum sfactor, GLenum dfactor) {
+	if (sfactor == blend_sfactor && dfactor == blend_dfactor) {
+		skipped += 1;
+		return;
+	}
+	glBlendFunc(sfactor, dfactor);
+	blend_sfactor = sfactor;
+	blend_dfactor = dfactor;
+	issued += 1;
+}
+
+void GLState::forget() {
+	program = Unknown;
+	vertex_array = Unknown;
+	array_buffer = Unknown;
+	uniform_buffer = Unknown;
+	unit = Unknown;
+	for (auto &t : texture_2d) t = Unknown;
+	blend = depth_test = cull_face = scissor_test = Unset;
+	blend_sfactor = blend_dfactor = Unknown;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <stdint.h>
+
+/*
+ * GLState shadows commonly-changed OpenGL state (bound program, vertex array, buffers, textures, blending, depth test)
+ *  and skips calls that wouldn't change it, so code can set the state it needs before each draw without
+ *  paying driver overhead for state that is already set -- and without resetting everything to 0 afterward.
+ *
+ * This only works if every change to the tracked state goes through gl_state. After anything that changes it
+ *  behind gl_state's back -- including deleting a bound buffer, vertex array, or texture, which unbinds it
+ *  (and frees its name for reuse) -- call gl_state.forget().
+ *
+ * Tracked: current program; vertex array; GL_ARRAY_BUFFER and GL_UNIFORM_BUFFER bindings; active texture unit;
+ *  GL_TEXTURE_2D binding of the first 16 units; GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, GL_SCISSOR_TEST; blend function.
+ * Other targets and capabilities are passed straight through (and counted as issued).
+ */
+
+struct GLState {
+	GLState() { forget(); }
+
+	void use_program(GLuint program);
+	void bind_vertex_array(GLuint array);
+	void bind_buffer(GLenum target, GLuint buffer);
+	//(also binds 'buffer' to 'target' itself, as glBindBufferRange does)
+	void bind_buffer_range(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+	void active_texture(GLenum unit);
+	//binds to the active unit:
+	void bind_texture(GLenum target, GLuint texture);
+	void enable(GLenum capability);
+	void disable(GLenum capability);
+	void blend_func(GLenum sfactor, GLenum dfactor);
+
+	//treat all state as unknown (the next call for each piece of state will be issued):
+	void forget();
+
+	//counters (running totals):
+	uint64_t issued = 0; //calls passed on to OpenGL
+	uint64_t skipped = 0; //calls that would not have changed anything
+	uint64_t binds = 0; //issued calls that bound a program, vertex array, buffer, or texture (also counted in 'issued')
+
+	//----- internals -----
+	static constexpr GLuint Unknown = -1U; //(not a name OpenGL hands out)
+	static constexpr uint32_t Units = 16; //texture units whose GL_TEXTURE_2D binding is tracked
+
+	GLuint program = Unknown;
+	GLuint vertex_array = Unknown;
+	GLuint array_buffer = Unknown;
+	GLuint uniform_buffer = Unknown;
+	GLenum unit = Unknown; //(as GL_TEXTURE0 + i)
+	GLuint texture_2d[Units];
+	enum : int8_t { Off = 0, On = 1, Unset = -1 };
+	int8_t blend = Unset, depth_test = Unset, cull_face = Unset, scissor_test = Unset;
+	GLenum blend_sfactor = Unknown, blend_dfactor = Unknown;
+
+	int8_t *capability_state(GLenum capability); //null if not tracked
+};
+
+//OpenGL state is per-context, and this game has one:
+extern GLState gl_state;
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * MappedFile is a read-only view of a whole file, memory-mapped,
+ *  so the file's bytes can be read straight out of the page cache (no stream, no copy).
+ *
+ * Throws if the file can't be opened or mapped. An empty file maps to data == nullptr, size == 0.
+ */
+
+struct MappedFile {
+	MappedFile(std::string const &filename);
+	~MappedFile();
+	MappedFile(MappedFile const &) = delete;
+	MappedFile &operator=(MappedFile const &) = delete;
+
+	uint8_t const *data = nullptr;
+	size_t size = 0;
+
+	//platform handles:
+#ifdef _WIN32
+	void *file = nullptr; //HANDLE
+	void *mapping = nullptr; //HANDLE
+#else
+	int fd = -1;
+#endif
+};
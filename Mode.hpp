@@ -15,11 +15,17 @@ struct Mode : std::enable_shared_from_this< Mode > {
 
 	//update is called at the start of a new frame, after events are handled:
 	// 'elapsed' is time in seconds since the last call to 'update'
+	// (once the game has warmed up, update and draw should not allocate; see allocation_count.hpp and 'pong --check-allocations')
 	virtual void update(float elapsed) { }
 
 	//draw is called after update:
 	virtual void draw(glm::uvec2 const &drawable_size) = 0;
 
+	//how far (0 to 1) the moment being drawn is past the last update, as a fraction of that update's 'elapsed':
+	// (set by the main loop before draw; with a fixed timestep, update runs zero or more times per frame,
+	//  so draw can blend the last two updates' positions by this to keep motion smooth)
+	float update_alpha = 1.0f;
+
 	virtual bool curGameState() { return false; }
 
 	//Mode::current is the Mode to which events are dispatched.
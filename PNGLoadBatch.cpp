@@ -0,0 +1,79 @@
+#include "PNGLoadBatch.hpp"
+
+#include "ThreadPool.hpp"
+
+#include <cassert>
+
+PNGLoadBatch::PNGLoadBatch(std::vector< std::string > const &filenames, OriginLocation origin_) : origin(origin_) {
+	images.resize(filenames.size());
+	for (uint32_t i = 0; i < images.size(); ++i) {
+		images[i].index = i;
+		images[i].filename = filenames[i];
+	}
+	finished.reserve(images.size());
+	decoding = uint32_t(images.size());
+
+	//(the pool hands out one image at a time to whichever thread is free, so a few big images don't hold up the rest)
+	ThreadPool::shared().async_for(uint32_t(images.size()), [this](uint32_t i){
+		Image &image = images[i];
+		try {
+			load_png(image.filename, &image.size, &image.data, origin);
+		} catch (std::exception const &e) {
+			image.error = e.what();
+			image.size = glm::uvec2(0);
+			image.data.clear();
+		}
+		//(notified with the lock held, since the destructor may run as soon as 'decoding' hits zero)
+		std::unique_lock< std::mutex > lock(mutex);
+		finished.emplace_back(i);
+		decoding -= 1;
+		cv.notify_all();
+	});
+}
+
+PNGLoadBatch::~PNGLoadBatch() {
+	std::unique_lock< std::mutex > lock(mutex);
+	cv.wait(lock, [this](){ return decoding == 0; });
+}
+
+bool PNGLoadBatch::poll(std::function< void(Image &) > const &loaded) {
+	std::vector< uint32_t > ready;
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		ready.swap(finished);
+		finished.reserve(ready.capacity());
+	}
+	hand_back(ready, loaded);
+	return remaining() == 0;
+}
+
+void PNGLoadBatch::wait(std::function< void(Image &) > const &loaded) {
+	while (remaining() != 0) {
+		std::vector< uint32_t > ready;
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			cv.wait(lock, [this](){ return !finished.empty(); });
+			ready.swap(finished);
+			finished.reserve(ready.capacity());
+		}
+		hand_back(ready, loaded);
+	}
+}
+
+void PNGLoadBatch::hand_back(std::vector< uint32_t > const &indices, std::function< void(Image &) > const &loaded) {
+	for (uint32_t n = 0; n < indices.size(); ++n) {
+		Image &image = images[indices[n]];
+		try {
+			loaded(image);
+		} catch (...) {
+			//leave this image and the rest to be handed back by a later call:
+			std::unique_lock< std::mutex > lock(mutex);
+			finished.insert(finished.begin(), indices.begin() + n + 1, indices.end());
+			handed_back += 1;
+			throw;
+		}
+		handed_back += 1;
+		//don't keep decoded pixels around once the caller is done with them:
+		std::vector< glm::u8vec4 >().swap(image.data);
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "load_save_png.hpp"
+
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/*
+ * PNGLoadBatch decodes a list of PNG files in the background, on ThreadPool::shared(),
+ *  and hands each image back on the thread that calls poll() (or wait()) as soon as it's ready --
+ *  which is where anything that needs the OpenGL context (like uploading a texture) should happen.
+ *
+ * Usage (e.g., at startup):
+ *   PNGLoadBatch batch(filenames, LowerLeftOrigin);
+ *   batch.wait([&](PNGLoadBatch::Image &image){
+ *       if (image.error != "") throw std::runtime_error(image.error);
+ *       glBindTexture(GL_TEXTURE_2D, textures[image.index]);
+ *       glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image.size.x, image.size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.data.data());
+ *   });
+ * (or call poll() once per frame to keep a loading screen going)
+ *
+ * Images are decoded in whatever order the pool gets to them and handed back in the order they finish;
+ *  'index' says which filename each one came from.
+ */
+
+struct PNGLoadBatch {
+	PNGLoadBatch(std::vector< std::string > const &filenames, OriginLocation origin);
+	~PNGLoadBatch(); //waits for any decoding still running (images not yet handed back are dropped)
+	PNGLoadBatch(PNGLoadBatch const &) = delete;
+	PNGLoadBatch &operator=(PNGLoadBatch const &) = delete;
+
+	struct Image {
+		uint32_t index = 0; //position in 'filenames'
+		std::string filename;
+		glm::uvec2 size = glm::uvec2(0);
+		std::vector< glm::u8vec4 > data; //(freed after the callback returns; std::move it out to keep it)
+		std::string error; //non-empty if loading failed
+	};
+
+	//call 'loaded' for every image finished since the last call; returns true once all images have been handed back:
+	bool poll(std::function< void(Image &) > const &loaded);
+	//call 'loaded' for each image as it finishes, returning once all have been handed back:
+	void wait(std::function< void(Image &) > const &loaded);
+
+	uint32_t remaining() const { return uint32_t(images.size()) - handed_back; }
+
+	//----- internals -----
+
+	OriginLocation origin;
+	std::vector< Image > images; //one per filename
+	uint32_t handed_back = 0;
+
+	std::mutex mutex;
+	std::condition_variable cv; //signalled when an image finishes
+	std::vector< uint32_t > finished; //images decoded but not yet handed back
+	uint32_t decoding = 0; //images not yet finished (guarded by 'mutex')
+
+	void hand_back(std::vector< uint32_t > const &indices, std::function< void(Image &) > const &loaded);
+};
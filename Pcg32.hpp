@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Pcg32 is a small, fast, seedable random number generator (PCG-XSH-RR, 64-bit state, 32-bit output).
+ * The same seed (and stream) always gives the same sequence, on every platform,
+ *  which std::default_random_engine + std::uniform_real_distribution do not promise.
+ *
+ * See https://www.pcg-random.org/ for the algorithm.
+ */
+
+struct Pcg32 {
+	//'stream' picks one of 2^63 independent sequences:
+	explicit Pcg32(uint64_t seed = 0x853c49e6748fea9bULL, uint64_t stream = 0xda3e39cb94b95bdbULL) {
+		state = 0;
+		inc = (stream << 1) | 1;
+		next();
+		state += seed;
+		next();
+	}
+
+	//uniform over all 32-bit values:
+	uint32_t next() {
+		uint64_t old = state;
+		state = old * 6364136223846793005ULL + inc;
+		uint32_t xorshifted = uint32_t(((old >> 18) ^ old) >> 27);
+		uint32_t rot = uint32_t(old >> 59);
+		return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+	}
+
+	//uniform in [0,1) (24 random bits, so every value is exactly representable):
+	float unit() {
+		return float(next() >> 8) * (1.0f / 16777216.0f);
+	}
+
+	//uniform in [lo,hi):
+	float range(float lo, float hi) {
+		return lo + (hi - lo) * unit();
+	}
+
+	uint64_t state;
+	uint64_t inc;
+};
@@ -0,0 +1,561 @@
+#include "PongBatch.hpp"
+
+#include "aabb.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <cassert>
+
+PongBatch::PongBatch(uint32_t count, uint64_t first_seed) {
+	games.reserve(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		games.emplace_back(first_seed + i);
+	}
+
+	auto init = [count](std::vector< float > &v) { v.assign(count, 0.0f); };
+	init(paddle_y);
+	init(ball_x); init(ball_y);
+	init(velocity_x); init(velocity_y);
+	init(speed);
+	init(top_block_y); init(top_block_dir);
+	init(bottom_block_x); init(bottom_block_y); init(bottom_block_dir);
+	init(move_blocks);
+	init(live);
+	for (uint32_t g = 0; g < GateBoxes; ++g) {
+		init(gate_min_x[g]); init(gate_min_y[g]);
+		init(gate_max_x[g]); init(gate_max_y[g]);
+	}
+
+	hits.assign(count, 0);
+	init(end_x); init(end_y);
+	init(sweep_min_x); init(sweep_min_y); init(sweep_max_x); init(sweep_max_y);
+	paddle_x.assign(count, games.empty() ? 0.0f : games[0].left_paddle.x);
+	top_block_x.assign(count, games.empty() ? 0.0f : games[0].topBlock.x);
+	contacts.reserve(count);
+	finished.reserve(count);
+
+	lane_game.assign(count, 0); lane_state.assign(count, 0); lane_resolved.assign(count, 0);
+	init(lane_x); init(lane_y); init(lane_vx); init(lane_vy); init(lane_speed);
+	init(lane_remaining);
+	init(lane_paddle_y); init(lane_top_block_y); init(lane_bottom_block_x); init(lane_bottom_block_y);
+	for (uint32_t b = 0; b < PongSim::BoxCount; ++b) {
+		init(lane_min_x[b]); init(lane_min_y[b]);
+		init(lane_max_x[b]); init(lane_max_y[b]);
+	}
+	init(lane_motion_x); init(lane_motion_y);
+	init(lane_lo_x); init(lane_lo_y); init(lane_hi_x); init(lane_hi_y);
+	init(lane_reach_min_x); init(lane_reach_min_y); init(lane_reach_max_x); init(lane_reach_max_y);
+	lane_near.assign(count, 0);
+	init(lane_t);
+	lane_what.assign(count, 0); lane_in_y.assign(count, 0);
+	init(lane_box_t); lane_box_in_y.assign(count, 0);
+
+	for (uint32_t i = 0; i < count; ++i) {
+		arrays_from_sim(i);
+	}
+}
+
+void PongBatch::reset(uint32_t i, uint64_t seed) {
+	assert(i < size());
+	games[i] = PongSim(seed);
+	arrays_from_sim(i);
+}
+
+PongSim const &PongBatch::sync(uint32_t i) {
+	assert(i < size());
+	sim_from_arrays(i);
+	return games[i];
+}
+
+uint32_t PongBatch::gather_active_lanes(uint32_t lanes, uint32_t going) {
+	uint32_t front = 0, back = lanes;
+	while (front < going) {
+		if (lane_state[front] == LaneActive) {
+			++front;
+			continue;
+		}
+		do { --back; } while (lane_state[back] != LaneActive);
+		swap_lanes(front, back);
+		++front;
+	}
+	return going;
+}
+
+void PongBatch::swap_lanes(uint32_t a, uint32_t b) {
+	std::swap(lane_game[a], lane_game[b]);
+	std::swap(lane_state[a], lane_state[b]);
+	std::swap(lane_resolved[a], lane_resolved[b]);
+	std::swap(lane_x[a], lane_x[b]); std::swap(lane_y[a], lane_y[b]);
+	std::swap(lane_vx[a], lane_vx[b]); std::swap(lane_vy[a], lane_vy[b]);
+	std::swap(lane_speed[a], lane_speed[b]);
+	std::swap(lane_remaining[a], lane_remaining[b]);
+	std::swap(lane_paddle_y[a], lane_paddle_y[b]);
+	std::swap(lane_top_block_y[a], lane_top_block_y[b]);
+	std::swap(lane_bottom_block_x[a], lane_bottom_block_x[b]);
+	std::swap(lane_bottom_block_y[a], lane_bottom_block_y[b]);
+	for (uint32_t box = 0; box < PongSim::BoxCount; ++box) {
+		std::swap(lane_min_x[box][a], lane_min_x[box][b]); std::swap(lane_min_y[box][a], lane_min_y[box][b]);
+		std::swap(lane_max_x[box][a], lane_max_x[box][b]); std::swap(lane_max_y[box][a], lane_max_y[box][b]);
+	}
+}
+
+void PongBatch::sim_from_arrays(uint32_t i) {
+	PongSim &sim = games[i];
+	sim.left_paddle.y = paddle_y[i];
+	sim.ball = glm::vec2(ball_x[i], ball_y[i]);
+	sim.ball_velocity = glm::vec2(velocity_x[i], velocity_y[i]);
+	sim.topBlock.y = top_block_y[i];
+	sim.leftUp = (top_block_dir[i] > 0.0f);
+	sim.bottomBlock = glm::vec2(bottom_block_x[i], bottom_block_y[i]);
+	sim.rightUp = (bottom_block_dir[i] > 0.0f);
+}
+
+void PongBatch::arrays_from_sim(uint32_t i) {
+	PongSim const &sim = games[i];
+	paddle_y[i] = sim.left_paddle.y;
+	ball_x[i] = sim.ball.x;
+	ball_y[i] = sim.ball.y;
+	velocity_x[i] = sim.ball_velocity.x;
+	velocity_y[i] = sim.ball_velocity.y;
+	speed[i] = sim.speed_multiplier();
+	top_block_y[i] = sim.topBlock.y;
+	top_block_dir[i] = (sim.leftUp ? 1.0f : -1.0f);
+	bottom_block_x[i] = sim.bottomBlock.x;
+	bottom_block_y[i] = sim.bottomBlock.y;
+	bottom_block_dir[i] = (sim.rightUp ? 1.0f : -1.0f);
+	move_blocks[i] = (sim.moveBlocks ? 1.0f : 0.0f);
+	live[i] = (sim.gameState ? 1.0f : 0.0f);
+
+	//boxes are computed exactly as PongSim::overlap_mask() computes them, so overlap tests agree bit-for-bit:
+	auto set_box = [this,i](uint32_t g, glm::vec2 const &center, glm::vec2 const &radius, bool used) {
+		if (used) {
+			gate_min_x[g][i] = center.x - radius.x;
+			gate_min_y[g][i] = center.y - radius.y;
+			gate_max_x[g][i] = center.x + radius.x;
+			gate_max_y[g][i] = center.y + radius.y;
+		} else {
+			gate_min_x[g][i] = gate_min_y[g][i] = std::numeric_limits< float >::max();
+			gate_max_x[g][i] = gate_max_y[g][i] =-std::numeric_limits< float >::max();
+		}
+	};
+	set_box(0, sim.topCenter, sim.topRadius, true);
+	set_box(1, sim.bottomCenter, sim.bottomRadius, true);
+	set_box(2, sim.topCenterB, sim.topRadiusB, sim.useEarlier);
+	set_box(3, sim.bottomCenterB, sim.bottomRadiusB, sim.useEarlier);
+}
+
+//Moves one set of blocks (PongSim's "if (moveBlocks)" section), for all games at once:
+//Reset y direction if bounds are hit, then move (only once blocks move).
+//Written as selects + arithmetic instead of branches; m is 0 or 1 and directions are +1/-1, so this is exact.
+//(A separate function so the __restrict parameters let the compiler vectorize it.)
+static void move_blocks_kernel(uint32_t count, float *__restrict y, float *__restrict dir,
+	float const *__restrict moving, float const *__restrict alive,
+	float radius, float top, float bottom, float step) {
+	for (uint32_t i = 0; i < count; ++i) {
+		float m = moving[i] * alive[i];
+		float d = (y[i] - radius <= bottom ? 1.0f : dir[i]);
+		d = (y[i] + radius >= top ? -1.0f : d);
+		d = dir[i] + m * (d - dir[i]);
+		dir[i] = d;
+		y[i] += m * (d * step);
+	}
+}
+
+//Finds each ball's end point and its bounds over the step, and sets the wall bit where it reaches (or starts past) a wall:
+static void ball_bounds_kernel(uint32_t count, float elapsed,
+	float const *__restrict x, float const *__restrict y, float const *__restrict vx, float const *__restrict vy,
+	float const *__restrict spd, float const *__restrict alive,
+	float *__restrict end_x, float *__restrict end_y,
+	float *__restrict x0, float *__restrict y0, float *__restrict x1, float *__restrict y1, uint32_t *__restrict hit,
+	glm::vec2 const &ball_radius, glm::vec2 const &wall_lo, glm::vec2 const &wall_hi, uint32_t wall_bit) {
+	float const brx = ball_radius.x, bry = ball_radius.y;
+	float const wall_x_lo = wall_lo.x, wall_y_lo = wall_lo.y;
+	float const wall_x_hi = wall_hi.x, wall_y_hi = wall_hi.y;
+	for (uint32_t i = 0; i < count; ++i) {
+		float bx = x[i], by = y[i];
+		float s = alive[i] * (elapsed * spd[i]);
+		float ex = bx + s * vx[i];
+		float ey = by + s * vy[i];
+		end_x[i] = ex;
+		end_y[i] = ey;
+		float lo_x = std::min(bx, ex), hi_x = std::max(bx, ex);
+		float lo_y = std::min(by, ey), hi_y = std::max(by, ey);
+		x0[i] = lo_x - brx; x1[i] = hi_x + brx;
+		y0[i] = lo_y - bry; y1[i] = hi_y + bry;
+		bool inside = (lo_x > wall_x_lo) & (hi_x < wall_x_hi) & (lo_y > wall_y_lo) & (hi_y < wall_y_hi);
+		hit[i] = (inside ? 0u : wall_bit);
+	}
+}
+
+//Moves balls that touch nothing this step to their end points (swept games already hold their result):
+// (every operand is loaded up front, so the selects don't read as conditional loads and stores to the vectorizer)
+static void move_free_kernel(uint32_t count, uint32_t const *__restrict hit,
+	float const *__restrict end_x, float const *__restrict end_y, float *__restrict x, float *__restrict y) {
+	for (uint32_t i = 0; i < count; ++i) {
+		uint32_t h = hit[i];
+		float cx = x[i], cy = y[i];
+		float ex = end_x[i], ey = end_y[i];
+		x[i] = (h != 0 ? cx : ex);
+		y[i] = (h != 0 ? cy : ey);
+	}
+}
+
+//----- lane kernels (PongSim::sweep()'s contact loop, one pass at a time over every lane) -----
+
+//Lanes whose ball already overlaps a box ('overlap', the ball's own PongSim::overlap_mask()) or sits past a wall
+// need PongSim::collide() before they sweep, so they are left for PongSim::sweep(); the rest start sweeping.
+//Returns the number that do:
+static uint32_t lane_start_kernel(uint32_t count, float const *__restrict x, float const *__restrict y,
+	uint32_t const *__restrict overlap, uint32_t *__restrict state, glm::vec2 const &wall_lo, glm::vec2 const &wall_hi) {
+	float const wall_x_lo = wall_lo.x, wall_y_lo = wall_lo.y;
+	float const wall_x_hi = wall_hi.x, wall_y_hi = wall_hi.y;
+	uint32_t going = 0;
+	for (uint32_t i = 0; i < count; ++i) {
+		float bx = x[i], by = y[i];
+		//(collide()'s wall tests are strict, so a ball left against a wall by the last bounce is fine)
+		bool in_court = !(by > wall_y_hi) & !(by < wall_y_lo) & !(bx > wall_x_hi) & !(bx < wall_x_lo);
+		bool start = (overlap[i] == 0) & in_court;
+		state[i] = (start ? uint32_t(PongBatch::LaneActive) : uint32_t(PongBatch::LaneSweep));
+		going += (start ? 1u : 0u);
+	}
+	return going;
+}
+
+//Starts a round: each lane's motion for the rest of its step and the ball's bounds along it
+// (computed as PongSim::sweep_contacts() and first_contact() compute them), with the bounds also grown by the
+// ball's radius for the broad-phase overlap tests; clears the contact found so far and the broad-phase bits:
+static void lane_motion_kernel(uint32_t count,
+	float const *__restrict x, float const *__restrict y, float const *__restrict vx, float const *__restrict vy,
+	float const *__restrict speed, float const *__restrict remaining,
+	float *__restrict motion_x, float *__restrict motion_y,
+	float *__restrict lo_x, float *__restrict lo_y, float *__restrict hi_x, float *__restrict hi_y,
+	float *__restrict x0, float *__restrict y0, float *__restrict x1, float *__restrict y1,
+	float *__restrict t, uint32_t *__restrict what, uint32_t *__restrict in_y, uint32_t *__restrict near,
+	glm::vec2 const &ball_radius) {
+	float const brx = ball_radius.x, bry = ball_radius.y;
+	for (uint32_t i = 0; i < count; ++i) {
+		float s = remaining[i] * speed[i];
+		float mx = s * vx[i], my = s * vy[i];
+		float bx = x[i], by = y[i];
+		float ex = bx + mx, ey = by + my;
+		float l_x = (ex < bx ? ex : bx), l_y = (ey < by ? ey : by); //glm::min
+		float h_x = (bx < ex ? ex : bx), h_y = (by < ey ? ey : by); //glm::max
+		motion_x[i] = mx; motion_y[i] = my;
+		lo_x[i] = l_x; lo_y[i] = l_y;
+		hi_x[i] = h_x; hi_y[i] = h_y;
+		x0[i] = l_x - brx; y0[i] = l_y - bry;
+		x1[i] = h_x + brx; y1[i] = h_y + bry;
+		t[i] = 1.0f;
+		what[i] = PongSim::NoContact;
+		in_y[i] = 0;
+		near[i] = 0;
+	}
+}
+
+//PongSim::first_contact()'s consider() for box 'box' in every lane: keeps the contact aabb_contact_lanes() found
+// (at 'at', which is +infinity for none) if it is within the motion and strictly before the one found so far:
+static void lane_consider_kernel(uint32_t count, uint32_t box, float const *__restrict at, uint32_t const *__restrict at_in_y,
+	float *__restrict t, uint32_t *__restrict what, uint32_t *__restrict in_y) {
+	for (uint32_t i = 0; i < count; ++i) {
+		float a = at[i], best = t[i];
+		uint32_t a_in_y = at_in_y[i], found = what[i], found_in_y = in_y[i];
+		bool take = (a >= 0.0f) & (a <= 1.0f) & ((found == PongSim::NoContact) | (a < best));
+		t[i] = (take ? a : best);
+		what[i] = (take ? box : found);
+		in_y[i] = (take ? a_in_y : found_in_y);
+	}
+}
+
+//PongSim::first_contact()'s test for one wall in every lane: the time the ball's center reaches 'wall' along 'pos'
+// (x or y), if it is moving toward it ('toward_positive' or not) and gets there this round:
+static void lane_wall_kernel(uint32_t count, uint32_t wall, bool wall_in_y, bool toward_positive, float wall_at,
+	float const *__restrict pos, float const *__restrict motion, float const *__restrict lo, float const *__restrict hi,
+	float *__restrict t, uint32_t *__restrict what, uint32_t *__restrict in_y) {
+	for (uint32_t i = 0; i < count; ++i) {
+		float m = motion[i];
+		float l = lo[i], h = hi[i];
+		bool reaches = (toward_positive ? (m > 0.0f) & (h >= wall_at) : (m < 0.0f) & (l <= wall_at));
+		float at = (wall_at - pos[i]) / m;
+		float best = t[i];
+		uint32_t found = what[i], found_in_y = in_y[i];
+		bool take = reaches & (at >= 0.0f) & (at <= 1.0f) & ((found == PongSim::NoContact) | (at < best));
+		t[i] = (take ? at : best);
+		what[i] = (take ? wall : found);
+		in_y[i] = (take ? uint32_t(wall_in_y) : found_in_y);
+	}
+}
+
+//What lane_resolve_kernel needs to know about the court, paddle, and blocks (all the same in every game):
+struct LaneCourt {
+	float paddle_x, top_block_x;
+	glm::vec2 paddle_radius, block_radius, ball_radius;
+	glm::vec2 wall_lo, wall_hi; //where the ball's center stops at each wall
+};
+
+//Ends a round, as the body of PongSim::sweep_contacts() does: no contact moves the ball the whole way and ends
+// the lane's step; a bounce (PongSim::bounce() or wall_contact()) moves the ball to the contact, bounces it, and
+// keeps the lane going; a scoring contact, or running into PongSim::SweepLimit, leaves the lane for PongSim to finish.
+//(all selects, no branches; it stays scalar, though, since the compiler won't if-convert float compares that may trap)
+//Returns the number of lanes still going:
+static uint32_t lane_resolve_kernel(uint32_t count, uint32_t *__restrict state, uint32_t *__restrict resolved,
+	float *__restrict x, float *__restrict y, float *__restrict vx, float *__restrict vy, float *__restrict remaining,
+	float const *__restrict motion_x, float const *__restrict motion_y,
+	float const *__restrict t, uint32_t const *__restrict what, uint32_t const *__restrict in_y,
+	float const *__restrict paddle_y, float const *__restrict top_block_y,
+	float const *__restrict bottom_block_x, float const *__restrict bottom_block_y,
+	LaneCourt const &court) {
+	float const brx = court.ball_radius.x, bry = court.ball_radius.y;
+	float const wall_x_lo = court.wall_lo.x, wall_y_lo = court.wall_lo.y, wall_y_hi = court.wall_hi.y;
+	uint32_t going = 0;
+	for (uint32_t i = 0; i < count; ++i) {
+		//(everything is loaded up front, so the selects below don't read as conditional loads to the vectorizer)
+		uint32_t s = state[i], w = what[i], r = resolved[i];
+		bool box_in_y = (in_y[i] != 0);
+		float at = t[i];
+		float bx = x[i], by = y[i], bvx = vx[i], bvy = vy[i], rem = remaining[i];
+		float mx = motion_x[i], my = motion_y[i];
+		float pad_y = paddle_y[i], top_y = top_block_y[i], bottom_x = bottom_block_x[i], bottom_y = bottom_block_y[i];
+		bool none = (w == PongSim::NoContact);
+		bool scoring = (w == PongSim::RightWall) | ((w >= PongSim::TopGateBox) & (w <= PongSim::BottomGateBBox));
+
+		//move (all the way, or to the contact):
+		float nx = (none ? bx + mx : bx + at * mx);
+		float ny = (none ? by + my : by + at * my);
+
+		//PongSim::bounce() off the paddle or a block (as both its in_y cases):
+		bool paddle = (w == PongSim::PaddleBox);
+		bool top = (w == PongSim::TopBlockBox);
+		float cx = (paddle ? court.paddle_x : (top ? court.top_block_x : bottom_x));
+		float cy = (paddle ? pad_y : (top ? top_y : bottom_y));
+		float rx = (paddle ? court.paddle_radius.x : court.block_radius.x);
+		float ry = (paddle ? court.paddle_radius.y : court.block_radius.y);
+		float dif = (paddle ? 1.0f : -1.0f); //(blocks always inverse)
+		bool above = (ny > cy);
+		float y_bounce_y = (above ? cy + (ry + bry) : cy - ry - bry);
+		float y_bounce_vy = (above ? std::abs(bvy) : -std::abs(bvy));
+		bool right = (nx > cx);
+		float x_bounce_x = (right ? cx + (rx + brx) : cx - rx - brx);
+		float x_bounce_vx = (right ? std::abs(bvx) : -std::abs(bvx));
+		float x_bounce_vy = glm::mix(bvy, dif * (ny - cy) / (ry + bry), 0.75f);
+
+		//PongSim::wall_contact() for the walls that just bounce:
+		bool top_wall = (w == PongSim::TopWall), bottom_wall = (w == PongSim::BottomWall), left_wall = (w == PongSim::LeftWall);
+
+		bool box = (w <= PongSim::BottomBlockBox);
+		float fx = (box ? (box_in_y ? nx : x_bounce_x) : (left_wall ? wall_x_lo : nx));
+		float fy = (box ? (box_in_y ? y_bounce_y : ny) : (top_wall ? wall_y_hi : (bottom_wall ? wall_y_lo : ny)));
+		float fvx = (box ? (box_in_y ? bvx : x_bounce_vx) : (left_wall & (bvx < 0.0f) ? -bvx : bvx));
+		float fvy = (box ? (box_in_y ? y_bounce_vy : x_bounce_vy)
+			: ((top_wall & (bvy > 0.0f)) | (bottom_wall & (bvy < 0.0f)) ? -bvy : bvy));
+
+		bool active = (s == PongBatch::LaneActive);
+		bool moves = active & !scoring; //(a scoring contact is left for PongSim, untouched)
+		bool bounced = moves & !none;
+		r += (bounced ? 1u : 0u);
+		x[i] = (moves ? fx : bx);
+		y[i] = (moves ? fy : by);
+		vx[i] = (moves ? fvx : bvx);
+		vy[i] = (moves ? fvy : bvy);
+		remaining[i] = (bounced ? rem - at * rem : rem);
+		resolved[i] = r;
+
+		uint32_t next = (none ? uint32_t(PongBatch::LaneDone)
+			: (scoring | (r == PongSim::SweepLimit) ? uint32_t(PongBatch::LaneFinish) : uint32_t(PongBatch::LaneActive)));
+		next = (active ? next : s);
+		state[i] = next;
+		going += (next == PongBatch::LaneActive ? 1u : 0u);
+	}
+	return going;
+}
+
+void PongBatch::step(float elapsed) {
+	finished.clear();
+	if (games.empty()) return;
+
+	//all games share the template constants of a fresh PongSim:
+	PongSim const &c = games[0];
+	uint32_t const count = size();
+
+	//where the ball's center stops at each wall (as PongSim::first_contact() computes it):
+	glm::vec2 const wall_lo = -c.court_radius + c.ball_radius;
+	glm::vec2 const wall_hi =  c.court_radius - c.ball_radius;
+
+	//NOTE: loops below read through local __restrict pointers (or are kernels taking __restrict parameters)
+	// so the compiler knows the arrays don't alias and can turn each loop into vector code.
+	// (the pointers are scoped to end before PongSim::sweep() writes the arrays through arrays_from_sim())
+	{
+		float const paddle_lo = -c.court_radius.y + c.paddle_radius.y;
+		float const paddle_hi =  c.court_radius.y - c.paddle_radius.y;
+		float const block_r = c.block_radius.y;
+		float const block_top = c.maxTop * 2 * c.court_radius.y - c.court_radius.y;
+		float const block_bottom = c.minBottom * 2 * c.court_radius.y - c.court_radius.y;
+		float const block_step = elapsed * c.blockUpdate;
+
+		float *__restrict pad = paddle_y.data();
+		float const *__restrict alive = live.data();
+		float *__restrict tby = top_block_y.data();
+		float *__restrict tbd = top_block_dir.data();
+		float const *__restrict bbx = bottom_block_x.data();
+		float *__restrict bby = bottom_block_y.data();
+		float *__restrict bbd = bottom_block_dir.data();
+		float const *__restrict moving = move_blocks.data();
+
+		//----- advance (mirrors PongSim::advance) -----
+
+		for (uint32_t i = 0; i < count; ++i) {
+			pad[i] = std::min(std::max(pad[i], paddle_lo), paddle_hi);
+		}
+
+		move_blocks_kernel(count, tby, tbd, moving, alive, block_r, block_top, block_bottom, block_step);
+		move_blocks_kernel(count, bby, bbd, moving, alive, block_r, block_top, block_bottom, block_step);
+
+		//----- find games where the ball might touch something this step -----
+
+		//The ball's bounds over the whole step (start to end, computed as PongSim::first_contact() computes them)
+		// are tested lane-wise (game i's ball against game i's box) with aabb_overlap_lanes().
+		//Walls get one more bit, set whenever the ball reaches or starts past them.
+		//Games with no bits set take PongSim::sweep()'s "nothing near" path, so their ball just moves to the end point.
+		ball_bounds_kernel(count, elapsed, ball_x.data(), ball_y.data(), velocity_x.data(), velocity_y.data(), speed.data(), alive,
+			end_x.data(), end_y.data(), sweep_min_x.data(), sweep_min_y.data(), sweep_max_x.data(), sweep_max_y.data(), hits.data(),
+			c.ball_radius, wall_lo, wall_hi, 1u << PongSim::BoxCount);
+
+		float const *__restrict x0 = sweep_min_x.data();
+		float const *__restrict y0 = sweep_min_y.data();
+		float const *__restrict x1 = sweep_max_x.data();
+		float const *__restrict y1 = sweep_max_y.data();
+		uint32_t *__restrict hit = hits.data();
+
+		aabb_overlap_lanes(count, x0, y0, x1, y1, paddle_x.data(), pad, c.paddle_radius, 1u << PongSim::PaddleBox, hit);
+		aabb_overlap_lanes(count, x0, y0, x1, y1, top_block_x.data(), tby, c.block_radius, 1u << PongSim::TopBlockBox, hit);
+		aabb_overlap_lanes(count, x0, y0, x1, y1, bbx, bby, c.block_radius, 1u << PongSim::BottomBlockBox, hit);
+		for (uint32_t g = 0; g < GateBoxes; ++g) {
+			aabb_overlap_lanes(count, x0, y0, x1, y1,
+				gate_min_x[g].data(), gate_min_y[g].data(), gate_max_x[g].data(), gate_max_y[g].data(),
+				1u << (PongSim::TopGateBox + g), hit);
+		}
+	}
+
+	//----- everything else moves freely -----
+
+	move_free_kernel(count, hits.data(), end_x.data(), end_y.data(), ball_x.data(), ball_y.data());
+
+	//----- gather games that might touch something into lanes -----
+
+	contacts.clear();
+	for (uint32_t i = 0; i < count; ++i) {
+		if (hits[i] != 0 && live[i] > 0.0f) contacts.emplace_back(i);
+	}
+	uint32_t const lanes = uint32_t(contacts.size());
+	if (lanes == 0) return;
+
+	for (uint32_t l = 0; l < lanes; ++l) {
+		uint32_t i = contacts[l];
+		lane_game[l] = i;
+		lane_x[l] = ball_x[i]; lane_y[l] = ball_y[i];
+		lane_vx[l] = velocity_x[i]; lane_vy[l] = velocity_y[i];
+		lane_speed[l] = speed[i];
+		lane_remaining[l] = elapsed;
+		lane_resolved[l] = 0;
+		lane_paddle_y[l] = paddle_y[i];
+		lane_top_block_y[l] = top_block_y[i];
+		lane_bottom_block_x[l] = bottom_block_x[i];
+		lane_bottom_block_y[l] = bottom_block_y[i];
+
+		//boxes, as center -/+ radius (as PongSim::first_contact() computes them):
+		auto set_box = [this,l](uint32_t b, float x, float y, glm::vec2 const &radius) {
+			lane_min_x[b][l] = x - radius.x; lane_min_y[b][l] = y - radius.y;
+			lane_max_x[b][l] = x + radius.x; lane_max_y[b][l] = y + radius.y;
+		};
+		set_box(PongSim::PaddleBox, paddle_x[i], paddle_y[i], c.paddle_radius);
+		set_box(PongSim::TopBlockBox, top_block_x[i], top_block_y[i], c.block_radius);
+		set_box(PongSim::BottomBlockBox, bottom_block_x[i], bottom_block_y[i], c.block_radius);
+		for (uint32_t g = 0; g < GateBoxes; ++g) {
+			lane_min_x[PongSim::TopGateBox + g][l] = gate_min_x[g][i]; lane_min_y[PongSim::TopGateBox + g][l] = gate_min_y[g][i];
+			lane_max_x[PongSim::TopGateBox + g][l] = gate_max_x[g][i]; lane_max_y[PongSim::TopGateBox + g][l] = gate_max_y[g][i];
+		}
+
+		//the ball's own box, to find lanes PongSim::collide() has to deal with first:
+		lane_reach_min_x[l] = ball_x[i] - c.ball_radius.x; lane_reach_min_y[l] = ball_y[i] - c.ball_radius.y;
+		lane_reach_max_x[l] = ball_x[i] + c.ball_radius.x; lane_reach_max_y[l] = ball_y[i] + c.ball_radius.y;
+		lane_near[l] = 0;
+	}
+
+	auto overlap_boxes = [this](uint32_t active) {
+		for (uint32_t b = 0; b < PongSim::BoxCount; ++b) {
+			aabb_overlap_lanes(active, lane_reach_min_x.data(), lane_reach_min_y.data(), lane_reach_max_x.data(), lane_reach_max_y.data(),
+				lane_min_x[b].data(), lane_min_y[b].data(), lane_max_x[b].data(), lane_max_y[b].data(), 1u << b, lane_near.data());
+		}
+	};
+	overlap_boxes(lanes);
+	uint32_t going = lane_start_kernel(lanes, lane_x.data(), lane_y.data(), lane_near.data(), lane_state.data(), wall_lo, wall_hi);
+	uint32_t active = gather_active_lanes(lanes, going);
+
+	//----- sweep the lanes, one contact per round -----
+
+	LaneCourt court;
+	court.paddle_x = paddle_x[0];
+	court.top_block_x = top_block_x[0];
+	court.paddle_radius = c.paddle_radius;
+	court.block_radius = c.block_radius;
+	court.ball_radius = c.ball_radius;
+	court.wall_lo = wall_lo;
+	court.wall_hi = wall_hi;
+
+	while (active > 0) {
+		lane_motion_kernel(active, lane_x.data(), lane_y.data(), lane_vx.data(), lane_vy.data(), lane_speed.data(), lane_remaining.data(),
+			lane_motion_x.data(), lane_motion_y.data(), lane_lo_x.data(), lane_lo_y.data(), lane_hi_x.data(), lane_hi_y.data(),
+			lane_reach_min_x.data(), lane_reach_min_y.data(), lane_reach_max_x.data(), lane_reach_max_y.data(),
+			lane_t.data(), lane_what.data(), lane_in_y.data(), lane_near.data(), c.ball_radius);
+		overlap_boxes(active);
+
+		//every candidate contact, in PongSim::first_contact()'s order (earlier ones win ties):
+		auto box = [&](uint32_t b) {
+			aabb_contact_lanes(active, lane_x.data(), lane_y.data(), c.ball_radius, lane_motion_x.data(), lane_motion_y.data(),
+				lane_min_x[b].data(), lane_min_y[b].data(), lane_max_x[b].data(), lane_max_y[b].data(),
+				1u << b, lane_near.data(), lane_box_t.data(), lane_box_in_y.data());
+			lane_consider_kernel(active, b, lane_box_t.data(), lane_box_in_y.data(), lane_t.data(), lane_what.data(), lane_in_y.data());
+		};
+		auto wall = [&](uint32_t w, bool in_y, bool toward_positive, float at) {
+			lane_wall_kernel(active, w, in_y, toward_positive, at,
+				(in_y ? lane_y : lane_x).data(), (in_y ? lane_motion_y : lane_motion_x).data(),
+				(in_y ? lane_lo_y : lane_lo_x).data(), (in_y ? lane_hi_y : lane_hi_x).data(),
+				lane_t.data(), lane_what.data(), lane_in_y.data());
+		};
+		box(PongSim::PaddleBox);
+		box(PongSim::TopBlockBox);
+		box(PongSim::BottomBlockBox);
+		wall(PongSim::TopWall, true, true, wall_hi.y);
+		wall(PongSim::BottomWall, true, false, wall_lo.y);
+		wall(PongSim::RightWall, false, true, wall_hi.x);
+		box(PongSim::TopGateBox);
+		box(PongSim::BottomGateBox);
+		box(PongSim::TopGateBBox);
+		box(PongSim::BottomGateBBox);
+		wall(PongSim::LeftWall, false, false, wall_lo.x);
+
+		going = lane_resolve_kernel(active, lane_state.data(), lane_resolved.data(),
+			lane_x.data(), lane_y.data(), lane_vx.data(), lane_vy.data(), lane_remaining.data(),
+			lane_motion_x.data(), lane_motion_y.data(), lane_t.data(), lane_what.data(), lane_in_y.data(),
+			lane_paddle_y.data(), lane_top_block_y.data(), lane_bottom_block_x.data(), lane_bottom_block_y.data(), court);
+		active = gather_active_lanes(active, going);
+	}
+
+	//----- scatter the lanes back; PongSim finishes any that need it -----
+	// (lanes were reordered as they finished, so 'finished' is sorted after to keep it in game order)
+
+	for (uint32_t l = 0; l < lanes; ++l) {
+		uint32_t i = lane_game[l];
+		ball_x[i] = lane_x[l]; ball_y[i] = lane_y[l];
+		velocity_x[i] = lane_vx[l]; velocity_y[i] = lane_vy[l];
+		lane_contacts += lane_resolved[l];
+		if (lane_state[l] == LaneDone) continue;
+
+		swept += 1;
+		sim_from_arrays(i);
+		if (lane_state[l] == LaneSweep) games[i].sweep(elapsed);
+		else games[i].sweep_contacts(lane_remaining[l], lane_resolved[l]);
+		arrays_from_sim(i);
+		if (!games[i].gameState) finished.emplace_back(i);
+	}
+	std::sort(finished.begin(), finished.end());
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "PongSim.hpp"
+
+#include <vector>
+#include <stdint.h>
+
+/*
+ * PongBatch steps many independent PongSim games at once.
+ *
+ * State touched every tick (ball, paddle, blocks, gate boxes) is kept as
+ *  structure-of-arrays so the per-tick work runs as flat loops over all games.
+ * Everything else lives in one PongSim per game ("cold" state).
+ *
+ * Games whose ball might touch something during a step are gathered into "lanes" (again structure-of-arrays),
+ *  where PongSim::sweep()'s contact loop runs as vector passes: find each ball's first contact (one pass
+ *  per box -- aabb_contact_lanes() -- and wall, in PongSim::first_contact()'s order, so ties break the same way),
+ *  then move the ball and bounce it off the wall, paddle, or block it hit, and repeat for the lanes that still
+ *  have motion left (gathered to the front each round).
+ *  Every float operation is the one PongSim does, in the same order, so lanes end bit-for-bit where
+ *  PongSim would ('pong-sim --self-check' compares the two).
+ *
+ * Contacts that score or cost a life (right wall, gates) draw new gates from the game's Pcg32, so a lane that
+ *  reaches one is synced back into its PongSim, which finishes the step with PongSim::sweep_contacts();
+ *  so do games collide() would have to untangle first (ball starting inside something), and steps that
+ *  run into PongSim::SweepLimit. That keeps those rules in exactly one place. 'swept' counts these
+ *  scalar steps; pong-sim reports it for a range of tick lengths.
+ *  (Steps longer than PongSim::MaxStep aren't sure to be stepped in full by either; see PongSim::dropped_steps.)
+ */
+
+struct PongBatch {
+	//game i is seeded with first_seed + i:
+	PongBatch(uint32_t count, uint64_t first_seed);
+
+	uint32_t size() const { return uint32_t(games.size()); }
+
+	//advance every live game by 'elapsed' seconds:
+	// (games whose lives run out are listed in 'finished' until the next step)
+	void step(float elapsed);
+
+	//start game 'i' over from scratch with a new seed:
+	void reset(uint32_t i, uint64_t seed);
+
+	//bring game 'i's PongSim up to date with the per-tick arrays and return it:
+	PongSim const &sync(uint32_t i);
+
+	//----- per-tick ("hot") state, one entry per game -----
+
+	std::vector< float > paddle_y; //set this before step() to move paddles
+	std::vector< float > ball_x, ball_y;
+	std::vector< float > velocity_x, velocity_y;
+	std::vector< float > speed; //PongSim::speed_multiplier(), cached per game
+	std::vector< float > top_block_y, top_block_dir; //dir is +1 (up) or -1 (down)
+	std::vector< float > bottom_block_x, bottom_block_y, bottom_block_dir;
+	std::vector< float > move_blocks; //1.0 once blocks move, else 0.0
+	std::vector< float > live; //1.0 while the game is running, else 0.0
+
+	//gate boxes as [min,max] per axis: 0 = top, 1 = bottom, 2 = top before, 3 = bottom before
+	// (same order as PongSim::TopGateBox ... BottomGateBBox)
+	// (before-gate boxes are inverted, so never overlap, until PongSim::useEarlier is set)
+	enum : uint32_t { GateBoxes = 4 };
+	std::vector< float > gate_min_x[GateBoxes], gate_min_y[GateBoxes];
+	std::vector< float > gate_max_x[GateBoxes], gate_max_y[GateBoxes];
+
+	//----- per-game cold state -----
+	std::vector< PongSim > games;
+
+	//games that ran out of lives during the last step():
+	std::vector< uint32_t > finished;
+
+	//game steps finished by PongSim::sweep() or sweep_contacts() (the scalar path), since construction:
+	uint64_t swept = 0;
+	//contacts resolved in lanes (the vector path), since construction:
+	uint64_t lane_contacts = 0;
+
+	//----- internals -----
+
+	//copy hot arrays -> games[i] and back:
+	void sim_from_arrays(uint32_t i);
+	void arrays_from_sim(uint32_t i);
+
+	//move the 'going' lanes still LaneActive among the first 'lanes' to the front (so each round only
+	// runs over lanes with motion left) and return how many that is:
+	uint32_t gather_active_lanes(uint32_t lanes, uint32_t going);
+	void swap_lanes(uint32_t a, uint32_t b); //(every per-lane array that lasts between rounds)
+
+	//paddle and top block x never change, but the overlap kernel wants one entry per game:
+	std::vector< float > paddle_x, top_block_x;
+
+	//scratch: per-game ball end point, ball bounds over the step, PongSim::overlap_mask() bits (plus one for walls),
+	// and the list of games that might touch something:
+	std::vector< float > end_x, end_y;
+	std::vector< float > sweep_min_x, sweep_min_y, sweep_max_x, sweep_max_y;
+	std::vector< uint32_t > hits;
+	std::vector< uint32_t > contacts;
+
+	//lanes: one per game in 'contacts' (sized for every game up front, so step() never allocates):
+	enum : uint32_t {
+		LaneActive, //still sweeping
+		LaneDone, //step finished in the lane
+		LaneSweep, //needs all of PongSim::sweep() (collide() would change something first)
+		LaneFinish, //needs PongSim::sweep_contacts() to finish the step (a scoring contact, or PongSim::SweepLimit)
+	};
+	std::vector< uint32_t > lane_game; //index into 'games'
+	std::vector< uint32_t > lane_state;
+	std::vector< uint32_t > lane_resolved; //contacts resolved so far this step
+	std::vector< float > lane_x, lane_y, lane_vx, lane_vy, lane_speed;
+	std::vector< float > lane_remaining; //seconds of motion left to sweep
+	std::vector< float > lane_paddle_y, lane_top_block_y, lane_bottom_block_x, lane_bottom_block_y; //(for bounces)
+	//every PongSim box as [min,max] per axis, in PongSim::PaddleBox ... BottomGateBBox order:
+	std::vector< float > lane_min_x[PongSim::BoxCount], lane_min_y[PongSim::BoxCount];
+	std::vector< float > lane_max_x[PongSim::BoxCount], lane_max_y[PongSim::BoxCount];
+	//this round's motion, the ball's bounds along it (as is, and grown by the ball's radius), the boxes those grown
+	// bounds reach (PongSim::overlap_mask() bits), and the first contact found so far (as in PongSim::Contact):
+	std::vector< float > lane_motion_x, lane_motion_y;
+	std::vector< float > lane_lo_x, lane_lo_y, lane_hi_x, lane_hi_y;
+	std::vector< float > lane_reach_min_x, lane_reach_min_y, lane_reach_max_x, lane_reach_max_y;
+	std::vector< uint32_t > lane_near;
+	std::vector< float > lane_t;
+	std::vector< uint32_t > lane_what, lane_in_y;
+	//...and the one box's contact being considered (from aabb_contact_lanes()):
+	std::vector< float > lane_box_t;
+	std::vector< uint32_t > lane_box_in_y;
+};
@@ -3,232 +3,133 @@
 //for the GL_ERRORS() macro:
 #include "gl_errors.hpp"
 
-//for glm::value_ptr() :
-#include <glm/gtc/type_ptr.hpp>
+//for skipping redundant state changes:
+#include "GLState.hpp"
 
-#include <random>
-#include<chrono>
-
-#define MOVING_PAD 0
-#define STATIONARY_PAD 1
-#define TOO_CLOSE 2
+#include <iostream>
+#include <utility>
+#include <new>
+#include <cassert>
 
 //Returns gameState so it is accesible to main
 bool PongMode::curGameState() {
-	return gameState;
+	return sim.gameState;
 }
 
-//Points is the current point count of player (just left_points)
-void PongMode::newGate(unsigned int points) {
-
-	//Setting level and gap params
-	unsigned int level = (points / levelPoints % 10) + 1; //In game level (goes up to 10)
-	if (points / levelPoints >= 10) useEarlier = true;
-	if (points / levelPoints >= 20) moveBlocks = true;
-	if(points / levelPoints >= 20) bottomBlock.x = newRightBlock.x;
-	float ratio = (maxGap - minGap) / 10.f; //How much to decreases size per level
-	float curGap = maxGap - (float) level * ratio; //Update gap and cap at min (level 10 +)
-	if (curGap <= minGap) curGap = minGap; 
-
-	//Generating random gate
-	unsigned seed = (unsigned int) std::chrono::system_clock::now().time_since_epoch().count(); //Creating seed,
-	//Found seed function from http://www.cplusplus.com/reference/random/uniform_real_distribution/operator()/
-	std::uniform_real_distribution < double > dist(0.0, 100.0 * (double) maxTop - 100.0*(double)(curGap + minBottom));
-	float curTop = (float) dist(std::default_random_engine(seed))/100.f + curGap + minBottom; //Randomly make new gate (top of gate gap)
-	dist.reset();
-	
-	//This lambda creates a new gate top for the before gate based on the after gate's top.
-	//@return - float, the percentage of the screen's y that the before gate's top is at
-	//@param - curTop - after gate's top in percentage, curGap - what percentage of the screen's y the gap should take
-	//seed - Seed created before to be used for random function (based on system clock)
-	auto givenBackTop = [this](float curTop, float curGap, unsigned seed) {
-		std::uniform_real_distribution < double > distDiv(1.5, 3.0);
-		//seedRes is intended to give a range of feasible but dynamic offsets for the before gap compared to after gap
-		float seedRes = (float)distDiv(std::default_random_engine(seed));
-
-		//See if putting gap above or below after goes out of bounds. If so, don't use
-		//Above gap is - yDivX ration * the x offset + a randomized 1/seedRes fraction of curGap above the after's gap
-		//Bottom is similar but below instead of above
-		bool justBottom = false;
-		float beforeUp = curTop + yDivXOffset * defXOffset + curGap/seedRes;
-		if (beforeUp >= maxTop + 0.03333) justBottom = true; //Error to make edge cases feasible without limiting the possible places for second gate
-		bool justTop = false;
-		float beforeDown = curTop - yDivXOffset * defXOffset - curGap/seedRes;
-		if (beforeDown - curGap <= minBottom) justTop = true;
-
-		assert(justTop || beforeDown >= minBottom + curGap);
-		assert(beforeUp >= minBottom + curGap);
-		if (justBottom)return beforeDown;
-		if (justTop) return beforeUp;
-
-		//If both are possible, do a coin flip to decide if to do above or below
-		assert(beforeDown >= minBottom + curGap && beforeUp >= minBottom + curGap && beforeUp > beforeDown);
-		std::uniform_real_distribution < double > dist(0.0, 1.0);
-		if(dist(std::default_random_engine(seed)) >= 0.5) return beforeDown;
-		return beforeUp;
-	};
-
-	//Creating gate coordinates
-	topRadius = glm::vec2(gateWidth, (1.0f - curTop) * court_radius.y + minBottom / 2); 
-	bottomRadius = glm::vec2(gateWidth, (curTop - curGap) * court_radius.y);
-	float topY = ((1.0f - curTop)/2 + curTop) * 2 * court_radius.y - court_radius.y;
-	topCenter = glm::vec2(gateX, topY);
-	float bottomY = bottomRadius.y - court_radius.y;
-	bottomCenter = glm::vec2(gateX, bottomY);
-	assert(bottomY - bottomRadius.y <= -0.499*court_radius.y);
-
-	//Creating earlier gate coordinates based off of first gate coordinates
-	float curTopB = givenBackTop(curTop, curGap, seed);
-	assert(curTopB - curGap >= minBottom - 0.0005f);
-	//Creating actual coordinates based on new top
-	topRadiusB = glm::vec2(gateWidth, (1.0f - curTopB) * court_radius.y + minBottom / 2);
-	bottomRadiusB = glm::vec2(gateWidth, (curTopB - curGap) * court_radius.y);
-	float topYB = ((1.0f - curTopB) / 2 + curTopB) * 2 * court_radius.y - court_radius.y;
-	topCenterB = glm::vec2(gateX - defXOffset*2*court_radius.x - 2 *gateWidth, topYB);
-	float bottomYB = bottomRadiusB.y - court_radius.y;
-	bottomCenterB = glm::vec2(gateX - defXOffset * 2 * court_radius.x - 2 * gateWidth, bottomYB);
-	assert(bottomYB - bottomRadiusB.y <= -0.499 * court_radius.y);
-	assert(topYB > bottomYB);
-	if (useEarlier) { //Make sure gap isn't right where player is to avoid cheating
-		if (recurLimit < 10 && abs(curTopB - curGap / 2 - left_paddle.y) <= curGap / TOO_CLOSE) {
-			recurLimit++;
-			newGate(left_score);
-		}
-	}
-	else {
-		if (recurLimit < 10 && abs(curTop - curGap / 2 - left_paddle.y) <= curGap / TOO_CLOSE) {
-			recurLimit++;
-			newGate(left_score);
-		}
-	}
-	recurLimit = 0; //Avoid infinite recursion
+PongMode::Programs PongMode::start_programs() {
+	Programs programs;
+	programs.color_rect = ColorRectProgram::start();
+	programs.color_texture = ColorTextureProgram::start();
+	return programs;
 }
 
-PongMode::PongMode() {
-
-	gameState = true; //Game should always play if the object is constructed 
-
-	left_score = 0;
+PongMode::PongMode(Programs &&programs, std::string const &record_to) :
+	color_rect_program(std::move(programs.color_rect)),
+	hud_atlas({ }, &texture_cache),
+	hud_batch(hud_atlas, std::move(programs.color_texture)) {
+	if (record_to != "") {
+		recorder.reset(new ReplayRecorder(record_to, sim.seed));
+	}
 
-	//Set up gate parameters
-	newGate(left_score);
+	//nothing has moved yet:
+	store_positions();
+	previous = current;
 
 	//set up trail as if ball has been here for 'forever':
 	ball_trail.clear();
-	ball_trail.emplace_back(ball, trail_length);
-	ball_trail.emplace_back(ball, 0.0f);
+	ball_trail.emplace_back(sim.ball, trail_clock - trail_length);
+	ball_trail.emplace_back(sim.ball, trail_clock);
 
 	
 	//----- allocate OpenGL resources -----
-	{ //vertex buffer:
-		glGenBuffers(1, &vertex_buffer);
-		//for now, buffer will be un-filled.
+	//(rect_buffer creates its own buffer; it will be filled by draw())
+	//(hud_atlas and hud_batch set up their own texture, buffer, and vertex array)
+
+	{ //unit quad buffer:
+		//two CCW-oriented triangles covering [-1,1]^2:
+		glm::vec2 corners[6] = {
+			glm::vec2(-1.0f,-1.0f), glm::vec2( 1.0f,-1.0f), glm::vec2( 1.0f, 1.0f),
+			glm::vec2(-1.0f,-1.0f), glm::vec2( 1.0f, 1.0f), glm::vec2(-1.0f, 1.0f),
+		};
+		glGenBuffers(1, &unit_quad_buffer);
+		gl_state.bind_buffer(GL_ARRAY_BUFFER, unit_quad_buffer);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
 
 		GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
 	}
 
-	{ //vertex array mapping buffer for color_texture_program:
-		//ask OpenGL to fill vertex_buffer_for_color_texture_program with the name of an unused vertex array object:
-		glGenVertexArrays(1, &vertex_buffer_for_color_texture_program);
-
-		//set vertex_buffer_for_color_texture_program as the current vertex array object:
-		glBindVertexArray(vertex_buffer_for_color_texture_program);
+	{ //vertex array mapping buffers for color_rect_program:
+		//ask OpenGL to fill rect_buffer_for_color_rect_program with the name of an unused vertex array object:
+		glGenVertexArrays(1, &rect_buffer_for_color_rect_program);
 
-		//set vertex_buffer as the source of glVertexAttribPointer() commands:
-		glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+		//set rect_buffer_for_color_rect_program as the current vertex array object:
+		gl_state.bind_vertex_array(rect_buffer_for_color_rect_program);
 
-		//set up the vertex array object to describe arrays of PongMode::Vertex:
+		//per-vertex: corners come from the unit quad:
+		gl_state.bind_buffer(GL_ARRAY_BUFFER, unit_quad_buffer);
 		glVertexAttribPointer(
-			color_texture_program.Position_vec4, //attribute
-			3, //size
-			GL_FLOAT, //type
-			GL_FALSE, //normalized
-			sizeof(Vertex), //stride
-			(GLbyte *)0 + 0 //offset
-		);
-		glEnableVertexAttribArray(color_texture_program.Position_vec4);
-		//[Note that it is okay to bind a vec3 input to a vec4 attribute -- the w component will be filled with 1.0 automatically]
-
-		glVertexAttribPointer(
-			color_texture_program.Color_vec4, //attribute
-			4, //size
-			GL_UNSIGNED_BYTE, //type
-			GL_TRUE, //normalized
-			sizeof(Vertex), //stride
-			(GLbyte *)0 + 4*3 //offset
-		);
-		glEnableVertexAttribArray(color_texture_program.Color_vec4);
-
-		glVertexAttribPointer(
-			color_texture_program.TexCoord_vec2, //attribute
+			color_rect_program.Corner_vec2, //attribute
 			2, //size
 			GL_FLOAT, //type
 			GL_FALSE, //normalized
-			sizeof(Vertex), //stride
-			(GLbyte *)0 + 4*3 + 4*1 //offset
+			sizeof(glm::vec2), //stride
+			(GLbyte *)0 + 0 //offset
 		);
-		glEnableVertexAttribArray(color_texture_program.TexCoord_vec2);
+		glEnableVertexAttribArray(color_rect_program.Corner_vec2);
 
-		//done referring to vertex_buffer, so unbind it:
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		//per-instance: rectangles come from rect_buffer, advancing once per instance:
+		// (the pointers themselves are set in draw(), since each frame uses a different region)
+		glVertexAttribDivisor(color_rect_program.Center_vec2, 1);
+		glEnableVertexAttribArray(color_rect_program.Center_vec2);
+		glVertexAttribDivisor(color_rect_program.Radius_vec2, 1);
+		glEnableVertexAttribArray(color_rect_program.Radius_vec2);
+		glVertexAttribDivisor(color_rect_program.Color_vec4, 1);
+		glEnableVertexAttribArray(color_rect_program.Color_vec4);
 
-		//done setting up vertex array object, so unbind it:
-		glBindVertexArray(0);
-
-		GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
-	}
-
-	{ //solid white texture:
-		//ask OpenGL to fill white_tex with the name of an unused texture object:
-		glGenTextures(1, &white_tex);
-
-		//bind that texture object as a GL_TEXTURE_2D-type texture:
-		glBindTexture(GL_TEXTURE_2D, white_tex);
-
-		//upload a 1x1 image of solid white to the texture:
-		glm::uvec2 size = glm::uvec2(1,1);
-		std::vector< glm::u8vec4 > data(size.x*size.y, glm::u8vec4(0xff, 0xff, 0xff, 0xff));
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
-
-		//set filtering and wrapping parameters:
-		//(it's a bit silly to mipmap a 1x1 texture, but I'm doing it because you may want to use this code to load different sizes of texture)
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-		//since texture uses a mipmap and we haven't uploaded one, instruct opengl to make one for us:
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		//Okay, texture uploaded, can unbind it:
-		glBindTexture(GL_TEXTURE_2D, 0);
+		//(nothing is unbound afterward: everything binds what it needs through gl_state, which skips binds that are already in place)
 
 		GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
 	}
 }
 
 PongMode::~PongMode() {
+	//finish the log if the game was cut short (e.g., by quitting):
+	if (recorder && !recorder->finished) {
+		try {
+			recorder->finish(sim);
+		} catch (std::exception const &e) {
+			std::cerr << "Failed to finish recording: " << e.what() << std::endl;
+		}
+	}
 
 	//----- free OpenGL resources -----
-	glDeleteBuffers(1, &vertex_buffer);
-	vertex_buffer = 0;
+	//(rect_buffer frees its own buffer)
+
+	glDeleteBuffers(1, &unit_quad_buffer);
+	unit_quad_buffer = 0;
 
-	glDeleteVertexArrays(1, &vertex_buffer_for_color_texture_program);
-	vertex_buffer_for_color_texture_program = 0;
+	glDeleteVertexArrays(1, &rect_buffer_for_color_rect_program);
+	rect_buffer_for_color_rect_program = 0;
 
-	glDeleteTextures(1, &white_tex);
-	white_tex = 0;
+	gl_state.forget(); //(deleting the buffer and vertex array unbinds them)
 }
 
 bool PongMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size) {
 
+	if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_F2) {
+		show_upload_stats = !show_upload_stats;
+		upload_stats_elapsed = 0.0f;
+		reset_upload_stats();
+		return true;
+	}
+
 	if (evt.type == SDL_MOUSEMOTION) {
 		//convert mouse from window pixels (top-left origin, +y is down) to clip space ([-1,1]x[-1,1], +y is up):
 		glm::vec2 clip_mouse = glm::vec2(
 			(evt.motion.x + 0.5f) / window_size.x * 2.0f - 1.0f,
 			(evt.motion.y + 0.5f) / window_size.y *-2.0f + 1.0f
 		);
-		left_paddle.y = (clip_to_court * glm::vec3(clip_mouse, 1.0f)).y;
+		sim.left_paddle.y = (clip_to_court * glm::vec3(clip_mouse, 1.0f)).y;
 	}
 
 	return false;
@@ -236,179 +137,86 @@ bool PongMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size)
 
 void PongMode::update(float elapsed) {
 
-	static std::mt19937 mt; //mersenne twister pseudo-random number generator
-
-	//----- paddle update -----
-
-	left_paddle.y = std::max(left_paddle.y, -court_radius.y + paddle_radius.y);
-	left_paddle.y = std::min(left_paddle.y,  court_radius.y - paddle_radius.y);
-
-
-	//----- ball update -----
-
-	//speed of ball doubles every (1/2 of total needef or level up) points for each level up, before slowing 3/4 with the next level:
-	int speedMultVal = ((left_score) / (3 * levelPoints));
-	if (left_score / levelPoints / 10 == 1 || left_score / levelPoints / 10 == 2) speedMultVal  = (left_score % (levelPoints * 10)) / (3*levelPoints);
-	else if (left_score / levelPoints / 10 >= 3)  speedMultVal = (left_score - 3* (levelPoints * 10)) / (3 * levelPoints);
-	float speed_multiplier = 4.0f * std::pow(1.3333f, (float) speedMultVal);
-
-	//velocity cap, though (otherwise ball can pass through paddles):
-	speed_multiplier = std::min(speed_multiplier, 10.0f);
-
-	ball += elapsed * speed_multiplier * ball_velocity;
-
-	if (moveBlocks) { //Only update block pos after level 20
-		if (topBlock.y + block_radius.y >= maxTop * 2 * court_radius.y - court_radius.y) leftUp = false; //Reset y direction if bounds are hit
-		else if (topBlock.y - block_radius.y <= minBottom * 2 * court_radius.y - court_radius.y) leftUp = true;
-		if (bottomBlock.y + block_radius.y >= maxTop * 2 * court_radius.y - court_radius.y) rightUp = false;
-		else if (bottomBlock.y - block_radius.y <= minBottom * 2 * court_radius.y - court_radius.y) rightUp = true;
-
-		if (leftUp) topBlock.y += elapsed * blockUpdate; //Depending on direction, update left and right blocks y based on elapsed delta in position
-		else topBlock.y -= elapsed * blockUpdate;
-		if (rightUp) bottomBlock.y += elapsed * blockUpdate;
-		else bottomBlock.y -= elapsed * blockUpdate;
+	if (recorder) recorder->record(sim.left_paddle.y, elapsed);
+	uint32_t score = sim.left_score, lives = sim.left_lives;
+	sim.update(elapsed);
+	if (recorder && !sim.gameState && !recorder->finished) recorder->finish(sim);
+
+	//remember where things were and are, for drawing in between updates:
+	store_positions();
+	last_elapsed = elapsed;
+	if (sim.left_score != score || sim.left_lives != lives) {
+		//(the ball was put back at the start, so don't draw it sliding there)
+		previous = current;
 	}
 
-	//---- collision handling ----
-
-	//Reset ball position along with new gate
-
-	auto moveBallLeft = [this]() {
-		ball = glm::vec2(-1.2f,left_paddle.y);
-		ball_velocity = glm::vec2(-1.0f, 0.0f);
-		if (ball.y < -court_radius.y + paddle_radius.y + ball_radius.y) ball.y = 1.1f * paddle_radius.y + ball_radius.y - court_radius.y;
-		if (ball.y > court_radius.y - paddle_radius.y - ball_radius.y) ball.y = -1.1f * paddle_radius.y - ball_radius.y + court_radius.y;
-
-	};
+	//----- gradient trails -----
 
-	//Sees purely if there is an overlap, ie collision, between balls and both gates
-	auto gateCollide = [this]() {
-		//After
-		//Top
-		glm::vec2 radius = topRadius;
-		glm::vec2 min = glm::max(topCenter - radius, ball - ball_radius);
-		glm::vec2 max = glm::min(topCenter + radius, ball + ball_radius);
-		if (!(min.x > max.x || min.y > max.y)) return true;
-		//Bottom
-		radius = bottomRadius;
-		min = glm::max(bottomCenter - radius, ball - ball_radius);
-		max = glm::min(bottomCenter + radius, ball + ball_radius);
-		if (!(min.x > max.x || min.y > max.y)) return true;
-		//Before
-		//Top
-		radius = topRadiusB;
-		min = glm::max(topCenterB - radius, ball - ball_radius);
-		max = glm::min(topCenterB + radius, ball + ball_radius);
-		if (!(min.x > max.x || min.y > max.y) && useEarlier) return true;
-		//Bottom
-		radius = bottomRadiusB;
-		min = glm::max(bottomCenterB - radius, ball - ball_radius);
-		max = glm::min(bottomCenterB + radius, ball + ball_radius);
-		if (!(min.x > max.x || min.y > max.y) && useEarlier) return true;
-		return false;
-		
-	};
+	//advance the trail clock (points are stamped with the time they were recorded, so nothing in the trail needs aging):
+	trail_clock += elapsed;
+	//store fresh location at back of ball trail:
+	ball_trail.emplace_back(sim.ball, trail_clock);
 
-	//paddles:
-	auto paddle_vs_ball = [this](glm::vec2 const &paddle, int whichPad) {
-		//compute area of overlap:
-		glm::vec2 radius = paddle_radius;
-		if (whichPad == STATIONARY_PAD) radius = block_radius;
-		glm::vec2 min = glm::max(paddle - radius, ball - ball_radius);
-		glm::vec2 max = glm::min(paddle + radius, ball + ball_radius);
-
-		//if no overlap, no collision:
-		if (min.x > max.x || min.y > max.y) return;
-
-		//Block always inverses
-		float difOffset = 1.0f;
-		if (whichPad == STATIONARY_PAD) difOffset = -1.0f;
-
-		if (max.x - min.x > max.y - min.y) {
-			//wider overlap in x => bounce in y direction:
-			if (ball.y > paddle.y) {
-				ball.y = paddle.y +(radius.y + ball_radius.y);
-				ball_velocity.y =  std::abs(ball_velocity.y);
-			} else {
-				ball.y = paddle.y - radius.y - ball_radius.y;
-				ball_velocity.y = -std::abs(ball_velocity.y);
-			}
-		} else {
-			//wider overlap in y => bounce in x direction:
-			if (ball.x > paddle.x) {
-				ball.x = paddle.x + (radius.x + ball_radius.x);
-				ball_velocity.x = std::abs(ball_velocity.x);
-			} else {
-				ball.x = paddle.x - radius.x - ball_radius.x;
-				ball_velocity.x = -std::abs(ball_velocity.x);
-			}
-			//warp y velocity based on offset from paddle center:
-			float vel = difOffset*(ball.y - paddle.y) / (radius.y + ball_radius.y);
-			ball_velocity.y = glm::mix(ball_velocity.y, vel, 0.75f);  //What? 
-		}
-	};
-	paddle_vs_ball(left_paddle, MOVING_PAD);
-	paddle_vs_ball(topBlock, STATIONARY_PAD);
-	paddle_vs_ball(bottomBlock, STATIONARY_PAD);
-	  
-	//court walls:
-	if (ball.y > court_radius.y - ball_radius.y) {
-		ball.y = court_radius.y - ball_radius.y;
-		if (ball_velocity.y > 0.0f) {
-			ball_velocity.y = -ball_velocity.y;
-		}
-	}
-	if (ball.y < -court_radius.y + ball_radius.y) {
-		ball.y = -court_radius.y + ball_radius.y;
-		if (ball_velocity.y < 0.0f) {
-			ball_velocity.y = -ball_velocity.y;
-		}
+	//trim any too-old locations from back of trail:
+	//NOTE: since trail drawing interpolates between points, only removes back element if second-to-back element is too old:
+	while (ball_trail.size() >= 2 && trail_clock - ball_trail[1].time > trail_length) {
+		ball_trail.pop_front();
 	}
 
-	if (ball.x > court_radius.x - ball_radius.x) {
-		ball.x = court_radius.x - ball_radius.x;
-		if (ball_velocity.x > 0.0f) {
-			moveBallLeft();
-			left_score += 1; 
-			newGate(left_score);
-		}
-	}
-	if (gateCollide()) {  //Checks hit with both gates
-		ball.x = gateX - ball_radius.x;
-		if (ball_velocity.x > 0.0f) {
-			left_lives--;
-			if (left_lives == 0) gameState = false; //If out of lives, restart the game
-			else {
-				moveBallLeft();
-				newGate(left_score); //Should reset gate even though they lost to avoid cheating
+	//----- rectangle upload stats -----
+
+	if (show_upload_stats) {
+		upload_stats_elapsed += elapsed;
+		if (upload_stats_elapsed >= 1.0f) {
+			uint64_t frames = rect_buffer.uses - upload_stats_frames;
+			if (frames) {
+				std::cout << "rectangle upload: " << (rect_buffer.bytes_uploaded - upload_stats_bytes) / frames << " bytes/frame, "
+					<< double(rect_buffer.stalls - upload_stats_stalls) / double(frames) << " stalls/frame"
+					<< " (" << frames << " frames)" << std::endl;
+				std::cout << "draw calls: " << double(draw_calls + hud_batch.draw_calls - upload_stats_draw_calls) / double(frames) << "/frame"
+					<< " (" << double(hud_batch.sprites_drawn - upload_stats_sprites) / double(frames) << " sprites/frame)" << std::endl;
+				std::cout << "gl state changes: " << double(gl_state.issued - upload_stats_issued) / double(frames) << " issued/frame"
+					<< " (" << double(gl_state.binds - upload_stats_binds) / double(frames) << " binds), "
+					<< double(gl_state.skipped - upload_stats_skipped) / double(frames) << " skipped/frame" << std::endl;
 			}
-			assert(left_lives > 0 || !gameState);
-		}
-	}
-	if (ball.x < -court_radius.x + ball_radius.x) {
-		ball.x = -court_radius.x  + ball_radius.x;
-		if (ball_velocity.x < 0.0f) {
-			ball_velocity.x = -ball_velocity.x;
+			upload_stats_elapsed = 0.0f;
+			reset_upload_stats();
 		}
 	}
+}
 
-	//----- gradient trails -----
-
-	//age up all locations in ball trail:
-	for (auto &t : ball_trail) {
-		t.z += elapsed;
-	}
-	//store fresh location at back of ball trail:
-	ball_trail.emplace_back(ball, 0.0f);
+void PongMode::reset_upload_stats() {
+	upload_stats_bytes = rect_buffer.bytes_uploaded;
+	upload_stats_stalls = rect_buffer.stalls;
+	upload_stats_frames = rect_buffer.uses;
+	upload_stats_issued = gl_state.issued;
+	upload_stats_skipped = gl_state.skipped;
+	upload_stats_binds = gl_state.binds;
+	upload_stats_draw_calls = draw_calls + hud_batch.draw_calls;
+	upload_stats_sprites = hud_batch.sprites_drawn;
+}
 
-	//trim any too-old locations from back of trail:
-	//NOTE: since trail drawing interpolates between points, only removes back element if second-to-back element is too old:
-	while (ball_trail.size() >= 2 && ball_trail[1].z > trail_length) {
-		ball_trail.pop_front();
-	}
+void PongMode::store_positions() {
+	previous = current;
+	current.ball = sim.ball;
+	current.paddle = sim.left_paddle;
+	current.top_block = sim.topBlock;
+	current.bottom_block = sim.bottomBlock;
 }
 
 void PongMode::draw(glm::uvec2 const &drawable_size) {
+	//draw moving things where they are 'update_alpha' of the way from the last update to the next:
+	// (with a fixed timestep, the moment being drawn is usually between updates)
+	auto blend = [this](glm::vec2 const &a, glm::vec2 const &b) {
+		return glm::mix(a, b, update_alpha);
+	};
+	glm::vec2 const ball = blend(previous.ball, current.ball);
+	glm::vec2 const paddle = blend(previous.paddle, current.paddle);
+	glm::vec2 const top_block = blend(previous.top_block, current.top_block);
+	glm::vec2 const bottom_block = blend(previous.bottom_block, current.bottom_block);
+	//the trail follows the drawn ball, so it is sampled back from that moment:
+	double const now = trail_clock - double(1.0f - update_alpha) * last_elapsed;
+
 	//some nice colors from the course web page:
 	#define HEX_TO_U8VEC4( HX ) (glm::u8vec4( (HX >> 24) & 0xff, (HX >> 16) & 0xff, (HX >> 8) & 0xff, (HX) & 0xff ))
 	glm::u8vec4 bgCols[10] = { HEX_TO_U8VEC4(0x193b59ff), HEX_TO_U8VEC4(0x038a8aff),
@@ -419,76 +227,85 @@ void PongMode::draw(glm::uvec2 const &drawable_size) {
 	const glm::u8vec4 block_color = HEX_TO_U8VEC4(0x387f3aff);
 	const glm::u8vec4 block_shadow_color = HEX_TO_U8VEC4(0x0d6410ff);
 	const glm::u8vec4 shadow_color = HEX_TO_U8VEC4(0xf2ad94ff);
-	const std::vector< glm::u8vec4 > trail_colors = {
+	static const glm::u8vec4 trail_colors[] = {
 		HEX_TO_U8VEC4(0xf2ad9488),
 		HEX_TO_U8VEC4(0xf2897288),
 		HEX_TO_U8VEC4(0xbacac088),
 	};
 	#undef HEX_TO_U8VEC4
+	constexpr uint32_t trail_color_count = sizeof(trail_colors) / sizeof(trail_colors[0]);
 
 	//other useful drawing constants:
 	const float wall_radius = 0.05f;
 	const float shadow_offset = 0.07f;
 	const float padding = 0.14f; //padding between outside of walls and edge of window
 
-	//---- compute vertices to draw ----
+	//---- compute rectangles to draw ----
+
+	//trail is drawn with this many rectangles (at most):
+	constexpr uint32_t STEPS = 20;
 
-	//vertices will be accumulated into this list and then uploaded+drawn at the end of this function:
-	std::vector< Vertex > vertices;
+	//most rectangles this function draws: 12 shadows, the trail, and 12 solid objects:
+	uint32_t const max_rectangles = 12 + STEPS + 12;
+
+	//rectangles will be written straight into rect_buffer (mapped here) and then drawn at the end of this function:
+	Rect *rects = reinterpret_cast< Rect * >(rect_buffer.map(max_rectangles * sizeof(Rect)));
+	uint32_t rect_count = 0;
 
 	//inline helper function for rectangle drawing:
-	auto draw_rectangle = [&vertices](glm::vec2 const &center, glm::vec2 const &radius, glm::u8vec4 const &color) {
-		//draw rectangle as two CCW-oriented triangles:
-		vertices.emplace_back(glm::vec3(center.x-radius.x, center.y-radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(center.x+radius.x, center.y-radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(center.x+radius.x, center.y+radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-
-		vertices.emplace_back(glm::vec3(center.x-radius.x, center.y-radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(center.x+radius.x, center.y+radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(center.x-radius.x, center.y+radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+	auto draw_rectangle = [&](glm::vec2 const &center, glm::vec2 const &radius, glm::u8vec4 const &color) {
+		assert(rect_count < max_rectangles && "max_rectangles must cover everything drawn");
+		//(placement-new, since the mapped memory holds no Rect objects yet)
+		new (rects + rect_count++) Rect(center, radius, color);
 	};
 
 	//shadows for everything (except the trail):
 
 	glm::vec2 s = glm::vec2(0.0f,-shadow_offset);
 
-	draw_rectangle(glm::vec2(-court_radius.x-wall_radius, 0.0f)+s, glm::vec2(wall_radius, court_radius.y + 2.0f * wall_radius), shadow_color);
-	draw_rectangle(glm::vec2( court_radius.x+wall_radius, 0.0f)+s, glm::vec2(wall_radius, court_radius.y + 2.0f * wall_radius), shadow_color);
-	draw_rectangle(glm::vec2( 0.0f,-court_radius.y-wall_radius)+s, glm::vec2(court_radius.x, wall_radius), shadow_color);
-	draw_rectangle(glm::vec2( 0.0f, court_radius.y+wall_radius)+s, glm::vec2(court_radius.x, wall_radius), shadow_color);
-	draw_rectangle(left_paddle + s, paddle_radius, shadow_color);
-	draw_rectangle(topBlock + s, block_radius, block_shadow_color);
-	draw_rectangle(bottomBlock + s, block_radius, block_shadow_color);
-	if(useEarlier){ //Only draw second gate if after level 10
-		draw_rectangle(topCenterB + s, topRadiusB, shadow_color);
-		draw_rectangle(bottomCenterB + s, bottomRadiusB, shadow_color);
+	draw_rectangle(glm::vec2(-sim.court_radius.x-wall_radius, 0.0f)+s, glm::vec2(wall_radius, sim.court_radius.y + 2.0f * wall_radius), shadow_color);
+	draw_rectangle(glm::vec2( sim.court_radius.x+wall_radius, 0.0f)+s, glm::vec2(wall_radius, sim.court_radius.y + 2.0f * wall_radius), shadow_color);
+	draw_rectangle(glm::vec2( 0.0f,-sim.court_radius.y-wall_radius)+s, glm::vec2(sim.court_radius.x, wall_radius), shadow_color);
+	draw_rectangle(glm::vec2( 0.0f, sim.court_radius.y+wall_radius)+s, glm::vec2(sim.court_radius.x, wall_radius), shadow_color);
+	draw_rectangle(paddle + s, sim.paddle_radius, shadow_color);
+	draw_rectangle(top_block + s, sim.block_radius, block_shadow_color);
+	draw_rectangle(bottom_block + s, sim.block_radius, block_shadow_color);
+	if(sim.useEarlier){ //Only draw second gate if after level 10
+		draw_rectangle(sim.topCenterB + s, sim.topRadiusB, shadow_color);
+		draw_rectangle(sim.bottomCenterB + s, sim.bottomRadiusB, shadow_color);
 	}
-	draw_rectangle(topCenter + s, topRadius, shadow_color);
-	draw_rectangle(bottomCenter + s, bottomRadius, shadow_color);
-	draw_rectangle(ball+s, ball_radius, shadow_color);
+	draw_rectangle(sim.topCenter + s, sim.topRadius, shadow_color);
+	draw_rectangle(sim.bottomCenter + s, sim.bottomRadius, shadow_color);
+	draw_rectangle(ball+s, sim.ball_radius, shadow_color);
 
 	//ball's trail:
 	if (ball_trail.size() >= 2) {
 		//start ti at second element so there is always something before it to interpolate from:
-		std::deque< glm::vec3 >::iterator ti = ball_trail.begin() + 1;
+		uint32_t ti = 1;
 		//draw trail from oldest-to-newest:
-		constexpr uint32_t STEPS = 20;
 		//draw from [STEPS, ..., 1]:
 		for (uint32_t step = STEPS; step > 0; --step) {
 			//time at which to draw the trail element:
-			float t = step / float(STEPS) * trail_length;
-			//advance ti until 'just before' t:
-			while (ti != ball_trail.end() && ti->z > t) ++ti;
+			double t = now - step / double(STEPS) * trail_length;
+			//binary search [ti, size) for the first point recorded at or after t:
+			// (times only increase along the trail, and t only increases with each step, so ti never moves back;
+			//  the cost is STEPS * log(trail size), however many points the frame rate has put in the trail)
+			uint32_t end = ball_trail.size();
+			while (ti < end) {
+				uint32_t mid = ti + (end - ti) / 2;
+				if (ball_trail[mid].time < t) ti = mid + 1;
+				else end = mid;
+			}
 			//if we ran out of recorded tail, stop drawing:
-			if (ti == ball_trail.end()) break;
+			if (ti == ball_trail.size()) break;
 			//interpolate between previous and current trail point to the correct time:
-			glm::vec3 a = *(ti-1);
-			glm::vec3 b = *(ti);
-			glm::vec2 at = (t - a.z) / (b.z - a.z) * (glm::vec2(b) - glm::vec2(a)) + glm::vec2(a);
+			TrailPoint const &a = ball_trail[ti-1];
+			TrailPoint const &b = ball_trail[ti];
+			glm::vec2 at = float((t - a.time) / (b.time - a.time)) * (b.position - a.position) + a.position;
 
 			//look up color using linear interpolation:
 			//compute (continuous) index:
-			float c = (step-1) / float(STEPS-1) * trail_colors.size();
+			float c = (step-1) / float(STEPS-1) * trail_color_count;
 			//split into an integer and fractional portion:
 			int32_t ci = int32_t(std::floor(c));
 			float cf = c - ci;
@@ -497,8 +314,8 @@ void PongMode::draw(glm::uvec2 const &drawable_size) {
 				ci = 0;
 				cf = 0.0f;
 			}
-			if (ci > int32_t(trail_colors.size())-2) {
-				ci = int32_t(trail_colors.size())-2;
+			if (ci > int32_t(trail_color_count)-2) {
+				ci = int32_t(trail_color_count)-2;
 				cf = 1.0f;
 			}
 			//do the interpolation (casting to floating point vectors because glm::mix doesn't have an overload for u8 vectors):
@@ -507,38 +324,38 @@ void PongMode::draw(glm::uvec2 const &drawable_size) {
 			);
 
 			//draw:
-			draw_rectangle(at, ball_radius, color);
+			draw_rectangle(at, sim.ball_radius, color);
 		}
 	}
 
 	//solid objects:
 
 	//walls:
-	draw_rectangle(glm::vec2(-court_radius.x-wall_radius, 0.0f), glm::vec2(wall_radius, court_radius.y + 2.0f * wall_radius), fg_color);
-	draw_rectangle(glm::vec2( court_radius.x+wall_radius, 0.0f), glm::vec2(wall_radius, court_radius.y + 2.0f * wall_radius), fg_color);
-	draw_rectangle(glm::vec2( 0.0f,-court_radius.y-wall_radius), glm::vec2(court_radius.x, wall_radius), fg_color);
-	draw_rectangle(glm::vec2( 0.0f, court_radius.y+wall_radius), glm::vec2(court_radius.x, wall_radius), fg_color);
-	draw_rectangle(topBlock, block_radius, block_color);
-	draw_rectangle(bottomBlock, block_radius, block_color);
+	draw_rectangle(glm::vec2(-sim.court_radius.x-wall_radius, 0.0f), glm::vec2(wall_radius, sim.court_radius.y + 2.0f * wall_radius), fg_color);
+	draw_rectangle(glm::vec2( sim.court_radius.x+wall_radius, 0.0f), glm::vec2(wall_radius, sim.court_radius.y + 2.0f * wall_radius), fg_color);
+	draw_rectangle(glm::vec2( 0.0f,-sim.court_radius.y-wall_radius), glm::vec2(sim.court_radius.x, wall_radius), fg_color);
+	draw_rectangle(glm::vec2( 0.0f, sim.court_radius.y+wall_radius), glm::vec2(sim.court_radius.x, wall_radius), fg_color);
+	draw_rectangle(top_block, sim.block_radius, block_color);
+	draw_rectangle(bottom_block, sim.block_radius, block_color);
 
 	//paddle:
-	draw_rectangle(left_paddle, paddle_radius, fg_color);
+	draw_rectangle(paddle, sim.paddle_radius, fg_color);
 
 	//gate:
-	draw_rectangle(topCenter, topRadius, fg_color); //Top
-	draw_rectangle(bottomCenter, bottomRadius, fg_color); //Bottom
-	if (useEarlier) {
-		draw_rectangle(topCenterB, topRadiusB, fg_color); //Top Before
-		draw_rectangle(bottomCenterB, bottomRadiusB, fg_color); //Bottom Before
+	draw_rectangle(sim.topCenter, sim.topRadius, fg_color); //Top
+	draw_rectangle(sim.bottomCenter, sim.bottomRadius, fg_color); //Bottom
+	if (sim.useEarlier) {
+		draw_rectangle(sim.topCenterB, sim.topRadiusB, fg_color); //Top Before
+		draw_rectangle(sim.bottomCenterB, sim.bottomRadiusB, fg_color); //Bottom Before
 	}
 
 	//ball:
-	draw_rectangle(ball, ball_radius, fg_color);
+	draw_rectangle(ball, sim.ball_radius, fg_color);
 
-	//scores:
+	//scores (queued as tinted white-texel sprites, so they look like rectangles; drawn by hud_batch.flush() below):
 	glm::vec2 score_radius = glm::vec2(0.1f, 0.1f);
-	for (uint32_t i = 1; i < left_lives; ++i) { //TO DO: Unknown if want to change this
-		draw_rectangle(glm::vec2( court_radius.x - (2.0f + 3.0f * i) * score_radius.x, court_radius.y + 2.0f * wall_radius + 2.0f * score_radius.y), score_radius, fg_color);
+	for (uint32_t i = 1; i < sim.left_lives; ++i) { //TO DO: Unknown if want to change this
+		hud_batch.draw(hud_atlas.white, glm::vec2( sim.court_radius.x - (2.0f + 3.0f * i) * score_radius.x, sim.court_radius.y + 2.0f * wall_radius + 2.0f * score_radius.y), score_radius, fg_color);
 	}
 
 
@@ -547,12 +364,12 @@ void PongMode::draw(glm::uvec2 const &drawable_size) {
 
 	//compute area that should be visible:
 	glm::vec2 scene_min = glm::vec2(
-		-court_radius.x - 2.0f * wall_radius - padding,
-		-court_radius.y - 2.0f * wall_radius - padding
+		-sim.court_radius.x - 2.0f * wall_radius - padding,
+		-sim.court_radius.y - 2.0f * wall_radius - padding
 	);
 	glm::vec2 scene_max = glm::vec2(
-		court_radius.x + 2.0f * wall_radius + padding,
-		court_radius.y + 2.0f * wall_radius + 3.0f * score_radius.y + padding
+		sim.court_radius.x + 2.0f * wall_radius + padding,
+		sim.court_radius.y + 2.0f * wall_radius + 3.0f * score_radius.y + padding
 	);
 
 	//compute window aspect ratio:
@@ -587,46 +404,72 @@ void PongMode::draw(glm::uvec2 const &drawable_size) {
 	//---- actual drawing ----
 
 	//clear the color buffer:
-	glm::u8vec4 bg_color = bgCols[(left_score / levelPoints) % 10]; //BG Color is picked for a series in order based on level
+	glm::u8vec4 bg_color = bgCols[(sim.left_score / sim.levelPoints) % 10]; //BG Color is picked for a series in order based on level
 	glClearColor(bg_color.r / 255.0f, bg_color.g / 255.0f, bg_color.b / 255.0f, bg_color.a / 255.0f);
 	glClear(GL_COLOR_BUFFER_BIT);
 
 	//use alpha blending:
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	gl_state.enable(GL_BLEND);
+	gl_state.blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	//don't use the depth test:
-	glDisable(GL_DEPTH_TEST);
-
-	//upload vertices to vertex_buffer:
-	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer); //set vertex_buffer as current
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(vertices[0]), vertices.data(), GL_STREAM_DRAW); //upload vertices array
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	//set color_texture_program as current program:
-	glUseProgram(color_texture_program.program);
-
-	//upload OBJECT_TO_CLIP to the proper uniform location:
-	glUniformMatrix4fv(color_texture_program.OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(court_to_clip));
-
-	//use the mapping vertex_buffer_for_color_texture_program to fetch vertex data:
-	glBindVertexArray(vertex_buffer_for_color_texture_program);
-
-	//bind the solid white texture to location zero so things will be drawn just with their colors:
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, white_tex);
+	gl_state.disable(GL_DEPTH_TEST);
+
+	//finish writing rectangles to rect_buffer:
+	GLintptr rect_offset = rect_buffer.unmap(rect_count * sizeof(Rect));
+
+	//upload this frame's shared uniforms (read by every program through the Frame block):
+	FrameUniforms::Data frame_data;
+	frame_data.WORLD_TO_CLIP = court_to_clip;
+	frame_data.DRAWABLE_SIZE = glm::vec2(drawable_size);
+	frame_data.TIME = float(trail_clock);
+	frame_uniforms.set(frame_data);
+
+	//set color_rect_program as current program:
+	gl_state.use_program(color_rect_program.program);
+
+	//use the mapping rect_buffer_for_color_rect_program to fetch vertex data:
+	gl_state.bind_vertex_array(rect_buffer_for_color_rect_program);
+
+	//point the per-instance attributes at this frame's region of rect_buffer:
+	// (OpenGL 3.3 has no "base instance" parameter, so the offset goes into the pointers)
+	gl_state.bind_buffer(GL_ARRAY_BUFFER, rect_buffer.buffer);
+	glVertexAttribPointer(
+		color_rect_program.Center_vec2, //attribute
+		2, //size
+		GL_FLOAT, //type
+		GL_FALSE, //normalized
+		sizeof(Rect), //stride
+		(GLbyte *)0 + rect_offset + 0 //offset
+	);
+	glVertexAttribPointer(
+		color_rect_program.Radius_vec2, //attribute
+		2, //size
+		GL_FLOAT, //type
+		GL_FALSE, //normalized
+		sizeof(Rect), //stride
+		(GLbyte *)0 + rect_offset + 4*2 //offset
+	);
+	glVertexAttribPointer(
+		color_rect_program.Color_vec4, //attribute
+		4, //size
+		GL_UNSIGNED_BYTE, //type
+		GL_TRUE, //normalized
+		sizeof(Rect), //stride
+		(GLbyte *)0 + rect_offset + 4*2 + 4*2 //offset
+	);
 
-	//run the OpenGL pipeline:
-	glDrawArrays(GL_TRIANGLES, 0, GLsizei(vertices.size()));
+	//run the OpenGL pipeline, drawing the six unit quad corners once per rectangle:
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 6, GLsizei(rect_count));
+	draw_calls += 1;
 
-	//unbind the solid white texture:
-	glBindTexture(GL_TEXTURE_2D, 0);
+	//extra-life markers on top (one more draw call, reading the same Frame uniforms):
+	hud_batch.flush();
 
-	//reset vertex array to none:
-	glBindVertexArray(0);
+	//the GPU reads this frame's rectangles (and uniforms) with the draws above, so mark where it will be done with them:
+	rect_buffer.fence();
+	frame_uniforms.fence();
 
-	//reset current program to none:
-	glUseProgram(0);
-	
+	//(program, vertex array, and buffer are left bound; next frame's binds of the same ones are skipped by gl_state)
 
 	GL_ERRORS(); //PARANOIA: print errors just in case we did something wrong.
 
@@ -1,47 +1,37 @@
-#include "ColorTextureProgram.hpp"
+#include "ColorRectProgram.hpp"
+#include "FrameUniforms.hpp"
+#include "SpriteAtlas.hpp"
+#include "SpriteBatch.hpp"
+#include "TextureCache.hpp"
+#include "BufferRing.hpp"
+#include "FixedRing.hpp"
+#include "PongSim.hpp"
+#include "Replay.hpp"
 
 #include "Mode.hpp"
 #include "GL.hpp"
 
 #include <glm/glm.hpp>
 
+#include <memory>
+#include <string>
 #include <vector>
-#include <deque>
 
 /*
  * PongMode is a game mode that implements a single-player game of Pong.
  */
 
 struct PongMode : Mode {
-	PongMode();
-	virtual ~PongMode();
+	//shader programs a PongMode draws with, begun (all at once, so they compile together) by start_programs():
+	// (start them as early as possible -- e.g., right after the context is made -- and do other setup while they build)
+	struct Programs {
+		GLPendingProgram color_rect, color_texture;
+	};
+	static Programs start_programs();
 
-	//Function to create new gates based on current score
-	void newGate(unsigned int score);
-	//Gap will be set from a percentage of veritcal play area. Will be converted to actual coordinates based on play area
-	float minGap = 0.1f; //Can be set in testing
-	float maxGap = 0.33f; //Can be set in testing
-	float minBottom = 0.1f;
-	float maxTop =  1.0f - minBottom;
-	int recurLimit = 0;
-
-	bool useEarlier = false; //Use a second gate before first
-	float defXOffset = 0.09f; //% offset between two gates
-	float yDivXOffset = 0.2f; // ratio offset added to the y gate offset regardless of additional offset related to gap
-
-	//Said actual coordinates
-	glm::vec2 topRadius;
-	glm::vec2 bottomRadius;
-	glm::vec2 topCenter;
-	glm::vec2 bottomCenter;
-
-	//"B"efore gate (earlier gate after level 10)
-	glm::vec2 topRadiusB;
-	glm::vec2 bottomRadiusB;
-	glm::vec2 topCenterB;
-	glm::vec2 bottomCenterB;
-
-	uint32_t levelPoints = 3;
+	//if 'record_to' is given, the game is recorded there (see Replay.hpp):
+	PongMode(Programs &&programs, std::string const &record_to = "");
+	virtual ~PongMode();
 
 	//functions called by main loop:
 	virtual bool handle_event(SDL_Event const &, glm::uvec2 const &window_size) override;
@@ -50,34 +40,19 @@ struct PongMode : Mode {
 	virtual bool curGameState() override; 
 	//----- game state -----
 
-	bool gameState = true;
-
-	glm::vec2 court_radius = glm::vec2(7.0f, 5.0f);
-	glm::vec2 paddle_radius = glm::vec2(0.2f, 1.0f);
-	glm::vec2 block_radius = glm::vec2(0.2f, 0.5f);
-	glm::vec2 ball_radius = glm::vec2(0.2f, 0.2f);
-	float gateWidth = 0.2f; //Can be changed, x axis
-	glm::vec2 wallObj_radius = glm::vec2(0.05f, 5.0f);
-
-	glm::vec2 left_paddle = glm::vec2(-court_radius.x + 0.5f, 0.0f);
-	glm::vec2 right_paddle = glm::vec2( court_radius.x - 0.5f, 0.0f);
-	float gateX = court_radius.x - 2.0f;
-	glm::vec2 leftWall = glm::vec2(-court_radius.x, 0.0f);
-	glm::vec2 topBlock = glm::vec2(0.0f, court_radius.y/2.f);
-	glm::vec2 bottomBlock = glm::vec2(0.0f, -court_radius.y/2.f);
-	glm::vec2 newRightBlock = glm::vec2(1.5f, -court_radius.y / 2.f);
-
-
-	bool moveBlocks = false;
-	float blockUpdate = .75f;
-	bool leftUp = false;
-	bool rightUp = true;
+	//gameplay (ball, paddle, blocks, gates, score) lives in a window-free simulation:
+	PongSim sim;
 
-	glm::vec2 ball = glm::vec2(0.0f, 0.0f);
-	glm::vec2 ball_velocity = glm::vec2(-1.0f, 0.0f);
+	//input log for replaying this game, if recording:
+	std::unique_ptr< ReplayRecorder > recorder;
 
-	uint32_t left_score = 0;
-	uint32_t left_lives = 45;
+	//positions after the last two updates, blended by update_alpha in draw():
+	struct Positions {
+		glm::vec2 ball, paddle, top_block, bottom_block;
+	};
+	Positions previous, current;
+	float last_elapsed = 0.0f; //'elapsed' of the last update
+	void store_positions(); //previous = current; current = positions in sim
 
 	float ai_offset = 0.0f;
 	float ai_offset_update = 0.0f;
@@ -85,35 +60,66 @@ struct PongMode : Mode {
 	//----- pretty gradient trails -----
 
 	float trail_length = 1.3f;
-	std::deque< glm::vec3 > ball_trail; //stores (x,y,age), oldest elements first
+	double trail_clock = 0.0; //seconds of update() so far; trail points are stamped with this, so they never need aging
+	struct TrailPoint {
+		TrailPoint() = default;
+		TrailPoint(glm::vec2 const &position_, double time_) : position(position_), time(time_) { }
+		glm::vec2 position;
+		double time; //(double so stamps stay precise however long the game runs)
+	};
+	FixedRing< TrailPoint, 1024 > ball_trail; //oldest elements first
+	// (fixed capacity so the trail never allocates; only frame rates above ~780fps would fill it, which shortens the trail)
 
 	//----- opengl assets / helpers ------
 
-	//draw functions will work on vectors of vertices, defined as follows:
-	struct Vertex {
-		Vertex(glm::vec3 const &Position_, glm::u8vec4 const &Color_, glm::vec2 const &TexCoord_) :
-			Position(Position_), Color(Color_), TexCoord(TexCoord_) { }
-		glm::vec3 Position;
+	//draw functions will work on arrays of rectangles, defined as follows:
+	// (each one is drawn as an instance of a unit quad, so it costs 20 bytes instead of six vertices)
+	struct Rect {
+		Rect(glm::vec2 const &Center_, glm::vec2 const &Radius_, glm::u8vec4 const &Color_) :
+			Center(Center_), Radius(Radius_), Color(Color_) { }
+		glm::vec2 Center;
+		glm::vec2 Radius;
 		glm::u8vec4 Color;
-		glm::vec2 TexCoord;
 	};
-	static_assert(sizeof(Vertex) == 4*3 + 1*4 + 4*2, "PongMode::Vertex should be packed");
+	static_assert(sizeof(Rect) == 4*2 + 4*2 + 1*4, "PongMode::Rect should be packed");
+
+	//Shader program that draws instanced rectangles:
+	ColorRectProgram color_rect_program;
+
+	//Per-frame values (court-to-clip transform, time) shared by every program through their Frame uniform block:
+	FrameUniforms frame_uniforms;
+
+	//Extra-life markers are sprites (the atlas's white texel, tinted), drawn after the rectangles:
+	// (the atlas holds no images yet, but any added to it draw in the same call)
+	TextureCache texture_cache; //(the atlas reads its images through this, so later runs skip decoding them)
+	SpriteAtlas hud_atlas;
+	SpriteBatch hud_batch;
+
+	//Static buffer holding the six corners (two CCW triangles) of the unit quad [-1,1]^2:
+	GLuint unit_quad_buffer = 0;
 
-	//Shader program that draws transformed, vertices tinted with vertex colors:
-	ColorTextureProgram color_texture_program;
+	//Buffer used to hold per-instance rectangle data during drawing:
+	// (rectangles are written straight into a mapped region of this ring each frame)
+	BufferRing rect_buffer{GL_ARRAY_BUFFER, sizeof(Rect)};
 
-	//Buffer used to hold vertex data during drawing:
-	GLuint vertex_buffer = 0;
+	//glDrawArrays* calls made by draw() itself (running total; hud_batch counts its own):
+	uint64_t draw_calls = 0;
 
-	//Vertex Array Object that maps buffer locations to color_texture_program attribute locations:
-	GLuint vertex_buffer_for_color_texture_program = 0;
+	//press F2 to print rectangle upload stats, draw calls, and gl state changes (issued, skipped, binds) once a second:
+	bool show_upload_stats = false;
+	float upload_stats_elapsed = 0.0f;
+	uint64_t upload_stats_bytes = 0, upload_stats_stalls = 0, upload_stats_frames = 0; //ring counters at last print
+	uint64_t upload_stats_issued = 0, upload_stats_skipped = 0, upload_stats_binds = 0; //gl_state counters at last print
+	uint64_t upload_stats_draw_calls = 0, upload_stats_sprites = 0; //draw_calls + hud_batch.draw_calls, hud_batch.sprites_drawn at last print
+	void reset_upload_stats(); //set the "at last print" counters to the current ones
 
-	//Solid white texture:
-	GLuint white_tex = 0;
+	//Vertex Array Object that maps unit_quad_buffer and rect_buffer to color_rect_program attribute locations:
+	// (the per-instance attributes are re-pointed at each frame's region of rect_buffer in draw())
+	GLuint rect_buffer_for_color_rect_program = 0;
 
 	//matrix that maps from clip coordinates to court-space coordinates:
 	glm::mat3x2 clip_to_court = glm::mat3x2(1.0f);
-	// computed in draw() as the inverse of OBJECT_TO_CLIP
+	// computed in draw() as the inverse of WORLD_TO_CLIP
 	// (stored here so that the mouse handling code can use it to position the paddle)
 
 };
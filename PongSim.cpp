@@ -0,0 +1,527 @@
+#include "PongSim.hpp"
+
+#include "aabb.hpp"
+
+#include <chrono>
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+#define MOVING_PAD 0
+#define STATIONARY_PAD 1
+#define TOO_CLOSE 2
+
+PongSim::PongSim() : PongSim(uint64_t(std::chrono::system_clock::now().time_since_epoch().count())) {
+}
+
+PongSim::PongSim(uint64_t seed_) : seed(seed_), rng(seed_) {
+	gameState = true; //Game should always play if the object is constructed
+
+	left_score = 0;
+
+	//Set up gate parameters
+	newGate(left_score);
+}
+
+//Allowed gate tops for newGate(), as a few disjoint intervals to draw from uniformly:
+namespace {
+	struct GateTops {
+		static constexpr uint32_t Max = 6;
+		float lo[Max], hi[Max];
+		uint32_t count = 0;
+		float length = 0.0f; //total length of all intervals
+
+		//add [a,b) minus [skip_lo,skip_hi]:
+		void add_avoiding(float a, float b, float skip_lo, float skip_hi) {
+			add(a, std::min(b, skip_lo));
+			add(std::max(a, skip_hi), b);
+		}
+		void add(float a, float b) {
+			if (!(b > a)) return;
+			assert(count < Max);
+			lo[count] = a;
+			hi[count] = b;
+			count += 1;
+			length += b - a;
+		}
+		//the point 'u' (in [0,length)) along the intervals laid end to end:
+		float at(float u) const {
+			assert(count > 0);
+			for (uint32_t i = 0; i + 1 < count; ++i) {
+				if (u < hi[i] - lo[i]) return lo[i] + u;
+				u -= hi[i] - lo[i];
+			}
+			return std::min(lo[count-1] + u, hi[count-1]); //(in case rounding pushed u past the end)
+		}
+	};
+}
+
+//Points is the current point count of player (just left_points)
+void PongSim::newGate(unsigned int points) {
+
+	//Setting level and gap params
+	unsigned int level = (points / levelPoints % 10) + 1; //In game level (goes up to 10)
+	if (points / levelPoints >= 10) useEarlier = true;
+	if (points / levelPoints >= 20) moveBlocks = true;
+	if(points / levelPoints >= 20) bottomBlock.x = newRightBlock.x;
+	float ratio = (maxGap - minGap) / 10.f; //How much to decreases size per level
+	float curGap = maxGap - (float) level * ratio; //Update gap and cap at min (level 10 +)
+	if (curGap <= minGap) curGap = minGap; 
+
+	//Generating random gate (all draws come from the game's rng, so gates follow from the seed)
+
+	//seedRes is intended to give a range of feasible but dynamic offsets for the before gap compared to after gap
+	//Before gate's gap is yDivX ratio * the x offset + a randomized 1/seedRes fraction of curGap above or below the after's gap
+	float seedRes = rng.range(1.5f, 3.0f);
+	float backOffset = yDivXOffset * defXOffset + curGap / seedRes;
+	//coin flip for above or below, used when both are possible:
+	bool flipDown = (rng.unit() >= 0.5f);
+
+	//This lambda creates a new gate top for the before gate based on the after gate's top.
+	//@return - float, the percentage of the screen's y that the before gate's top is at
+	//@param - curTop - after gate's top in percentage
+	auto givenBackTop = [&](float curTop) {
+		//See if putting gap above or below after goes out of bounds. If so, don't use
+		bool justBottom = false;
+		float beforeUp = curTop + backOffset;
+		if (beforeUp >= maxTop + 0.03333f) justBottom = true; //Error to make edge cases feasible without limiting the possible places for second gate
+		bool justTop = false;
+		float beforeDown = curTop - backOffset;
+		if (beforeDown - curGap <= minBottom) justTop = true;
+
+		assert(justTop || beforeDown >= minBottom + curGap);
+		assert(beforeUp >= minBottom + curGap);
+		if (justBottom)return beforeDown;
+		if (justTop) return beforeUp;
+
+		//If both are possible, use the coin flip
+		assert(beforeDown >= minBottom + curGap && beforeUp >= minBottom + curGap && beforeUp > beforeDown);
+		if (flipDown) return beforeDown;
+		return beforeUp;
+	};
+
+	//Make sure gap isn't right where player is to avoid cheating:
+	//the gap that counts (the before gate's once it is used) may not have its top in [avoidLo, avoidHi]
+	// (i.e., gap center within curGap / TOO_CLOSE of the paddle, compared as the gate code always has)
+	float avoidLo = left_paddle.y + curGap / 2 - curGap / TOO_CLOSE;
+	float avoidHi = left_paddle.y + curGap / 2 + curGap / TOO_CLOSE;
+
+	//after gate's top is uniform over [lowTop, maxTop) minus the tops that put the counted gap in the avoided range;
+	//givenBackTop shifts the top by a fixed amount on each of (at most) three pieces of that range,
+	// so the allowed tops are a few intervals that can be drawn from directly (no retries):
+	float lowTop = curGap + minBottom;
+	GateTops tops;
+	if (useEarlier) {
+		float downFrom = std::max(lowTop, maxTop + 0.03333f - backOffset); //justBottom at or above this
+		float upTo = std::min(downFrom, minBottom + curGap + backOffset); //justTop at or below this
+		tops.add_avoiding(lowTop, upTo, avoidLo - backOffset, avoidHi - backOffset);
+		float shift = (flipDown ? -backOffset : backOffset);
+		tops.add_avoiding(std::max(lowTop, upTo), std::min(maxTop, downFrom), avoidLo - shift, avoidHi - shift);
+		tops.add_avoiding(downFrom, maxTop, avoidLo + backOffset, avoidHi + backOffset);
+	} else {
+		tops.add_avoiding(lowTop, maxTop, avoidLo, avoidHi);
+	}
+	float curTop;
+	if (tops.length > 0.0f) {
+		curTop = tops.at(rng.range(0.0f, tops.length));
+	} else {
+		//(nowhere avoids the paddle, so go anywhere)
+		curTop = rng.range(lowTop, maxTop);
+	}
+
+	//Creating gate coordinates
+	topRadius = glm::vec2(gateWidth, (1.0f - curTop) * court_radius.y + minBottom / 2); 
+	bottomRadius = glm::vec2(gateWidth, (curTop - curGap) * court_radius.y);
+	float topY = ((1.0f - curTop)/2 + curTop) * 2 * court_radius.y - court_radius.y;
+	topCenter = glm::vec2(gateX, topY);
+	float bottomY = bottomRadius.y - court_radius.y;
+	bottomCenter = glm::vec2(gateX, bottomY);
+	assert(bottomY - bottomRadius.y <= -0.499*court_radius.y);
+
+	//Creating earlier gate coordinates based off of first gate coordinates
+	float curTopB = givenBackTop(curTop);
+	assert(curTopB - curGap >= minBottom - 0.0005f);
+	//Creating actual coordinates based on new top
+	topRadiusB = glm::vec2(gateWidth, (1.0f - curTopB) * court_radius.y + minBottom / 2);
+	bottomRadiusB = glm::vec2(gateWidth, (curTopB - curGap) * court_radius.y);
+	float topYB = ((1.0f - curTopB) / 2 + curTopB) * 2 * court_radius.y - court_radius.y;
+	topCenterB = glm::vec2(gateX - defXOffset*2*court_radius.x - 2 *gateWidth, topYB);
+	float bottomYB = bottomRadiusB.y - court_radius.y;
+	bottomCenterB = glm::vec2(gateX - defXOffset * 2 * court_radius.x - 2 * gateWidth, bottomYB);
+	assert(bottomYB - bottomRadiusB.y <= -0.499 * court_radius.y);
+	assert(topYB > bottomYB);
+}
+
+constexpr float PongSim::MaxSpeedMultiplier; //(std::min takes it by reference, so c++14 needs it defined)
+constexpr float PongSim::MaxStep;
+
+float PongSim::speed_multiplier() const {
+	//speed of ball doubles every (1/2 of total needef or level up) points for each level up, before slowing 3/4 with the next level:
+	int speedMultVal = ((left_score) / (3 * levelPoints));
+	if (left_score / levelPoints / 10 == 1 || left_score / levelPoints / 10 == 2) speedMultVal  = (left_score % (levelPoints * 10)) / (3*levelPoints);
+	else if (left_score / levelPoints / 10 >= 3)  speedMultVal = (left_score - 3* (levelPoints * 10)) / (3 * levelPoints);
+
+	//(sweep() stops the ball at every contact, so it can't pass through paddles at any speed;
+	// the cap only keeps the speed finite and each step within what SweepLimit contacts can cover)
+	return std::min(4.0f * std::pow(1.3333f, (float) speedMultVal), MaxSpeedMultiplier);
+}
+
+uint32_t PongSim::overlap_mask() const {
+	return overlap_mask(ball - ball_radius, ball + ball_radius);
+}
+
+uint32_t PongSim::overlap_mask(glm::vec2 const &ball_min, glm::vec2 const &ball_max) const {
+	//boxes as [min,max] per axis, computed exactly as the old per-box tests computed them:
+	//(padded to a whole number of vector lanes with an inverted box that never overlaps)
+	uint32_t const Slots = 8;
+	static_assert(BoxCount <= Slots, "boxes must fit in the padded arrays");
+	float min_x[Slots], min_y[Slots], max_x[Slots], max_y[Slots];
+	for (uint32_t b = BoxCount; b < Slots; ++b) {
+		min_x[b] = min_y[b] = std::numeric_limits< float >::max();
+		max_x[b] = max_y[b] =-std::numeric_limits< float >::max();
+	}
+	auto set_box = [&](uint32_t b, glm::vec2 const &center, glm::vec2 const &radius) {
+		glm::vec2 min = center - radius;
+		glm::vec2 max = center + radius;
+		min_x[b] = min.x; min_y[b] = min.y;
+		max_x[b] = max.x; max_y[b] = max.y;
+	};
+	set_box(PaddleBox, left_paddle, paddle_radius);
+	set_box(TopBlockBox, topBlock, block_radius);
+	set_box(BottomBlockBox, bottomBlock, block_radius);
+	set_box(TopGateBox, topCenter, topRadius);
+	set_box(BottomGateBox, bottomCenter, bottomRadius);
+	set_box(TopGateBBox, topCenterB, topRadiusB);
+	set_box(BottomGateBBox, bottomCenterB, bottomRadiusB);
+
+	uint32_t mask = aabb_overlap_mask(ball_min, ball_max, min_x, min_y, max_x, max_y, Slots);
+#ifdef PONGSIM_CHECK_OVERLAP
+	//(opt-in: check the vector kernel against the scalar one on every call; 'pong-sim --self-check' covers this without slowing the game)
+	assert(mask == aabb_overlap_mask_scalar(ball_min, ball_max, min_x, min_y, max_x, max_y, BoxCount));
+#endif
+	return mask;
+}
+
+void PongSim::update(float elapsed) {
+	advance(elapsed);
+	sweep(elapsed);
+}
+
+void PongSim::advance(float elapsed) {
+
+	//----- paddle update -----
+
+	left_paddle.y = std::max(left_paddle.y, -court_radius.y + paddle_radius.y);
+	left_paddle.y = std::min(left_paddle.y,  court_radius.y - paddle_radius.y);
+
+	//(the ball is moved by sweep(), against where the paddle and blocks end up)
+
+	if (moveBlocks) { //Only update block pos after level 20
+		if (topBlock.y + block_radius.y >= maxTop * 2 * court_radius.y - court_radius.y) leftUp = false; //Reset y direction if bounds are hit
+		else if (topBlock.y - block_radius.y <= minBottom * 2 * court_radius.y - court_radius.y) leftUp = true;
+		if (bottomBlock.y + block_radius.y >= maxTop * 2 * court_radius.y - court_radius.y) rightUp = false;
+		else if (bottomBlock.y - block_radius.y <= minBottom * 2 * court_radius.y - court_radius.y) rightUp = true;
+
+		if (leftUp) topBlock.y += elapsed * blockUpdate; //Depending on direction, update left and right blocks y based on elapsed delta in position
+		else topBlock.y -= elapsed * blockUpdate;
+		if (rightUp) bottomBlock.y += elapsed * blockUpdate;
+		else bottomBlock.y -= elapsed * blockUpdate;
+	}
+}
+
+void PongSim::sweep(float elapsed) {
+	glm::vec2 motion = elapsed * speed_multiplier() * ball_velocity;
+	Contact contact = first_contact(motion);
+
+	//common case: nothing anywhere near the ball's path, so it just moves:
+	if (contact.near == 0) {
+		ball += motion;
+		return;
+	}
+
+	//anything the paddle or blocks moved into is resolved where it is:
+	collide();
+
+	//then the ball travels, stopping at each contact along the way:
+	sweep_contacts(elapsed, 0);
+}
+
+void PongSim::sweep_contacts(float remaining, uint32_t resolved) {
+	for (uint32_t i = resolved; i < SweepLimit && gameState; ++i) {
+		glm::vec2 motion = remaining * speed_multiplier() * ball_velocity;
+		Contact contact = first_contact(motion);
+		if (contact.what == NoContact) {
+			ball += motion;
+			return;
+		}
+		ball += contact.t * motion;
+		remaining -= contact.t * remaining;
+		resolve(contact);
+	}
+	//(if SweepLimit contacts happen in one step, the rest of that step's motion is dropped;
+	// MaxSpeedMultiplier keeps steps up to MaxStep short enough that this doesn't happen, so count it when it does)
+	if (gameState && remaining > 0.0f) {
+		dropped_steps += 1;
+		dropped_time += remaining;
+	}
+}
+
+PongSim::Contact PongSim::first_contact(glm::vec2 const &motion) const {
+	Contact best;
+
+	//prefer the earliest contact; ties go to whatever collide() would have handled first:
+	auto consider = [&best](float t, uint32_t what, bool in_y) {
+		if (t >= 0.0f && t <= 1.0f && (best.what == NoContact || t < best.t)) {
+			best.what = what;
+			best.t = t;
+			best.in_y = in_y;
+		}
+	};
+
+	//broad phase: only look at what the ball's bounds touch anywhere along the motion:
+	glm::vec2 end = ball + motion;
+	glm::vec2 lo = glm::min(ball, end);
+	glm::vec2 hi = glm::max(ball, end);
+	uint32_t near = overlap_mask(lo - ball_radius, hi + ball_radius);
+	if (!useEarlier) near &= ~((1u << TopGateBBox) | (1u << BottomGateBBox));
+	glm::vec2 wall_hi = court_radius - ball_radius;
+	glm::vec2 wall_lo = -court_radius + ball_radius;
+	if (hi.y >= wall_hi.y) near |= (1u << TopWall);
+	if (lo.y <= wall_lo.y) near |= (1u << BottomWall);
+	if (lo.x <= wall_lo.x) near |= (1u << LeftWall);
+	if (hi.x >= wall_hi.x) near |= (1u << RightWall);
+	best.near = near;
+	if (near == 0) return best;
+
+	//boxes: time the expanded ball first overlaps the box on both axes at once:
+	glm::vec2 ball_min = ball - ball_radius;
+	glm::vec2 ball_max = ball + ball_radius;
+	auto sweep_box = [&](uint32_t what, glm::vec2 const &center, glm::vec2 const &radius) {
+		if (!(near & (1u << what))) return;
+		glm::vec2 box_min = center - radius;
+		glm::vec2 box_max = center + radius;
+		float enter[2], exit[2];
+		for (int a = 0; a < 2; ++a) {
+			if (motion[a] > 0.0f) {
+				enter[a] = (box_min[a] - ball_max[a]) / motion[a];
+				exit[a] = (box_max[a] - ball_min[a]) / motion[a];
+			} else if (motion[a] < 0.0f) {
+				enter[a] = (box_max[a] - ball_min[a]) / motion[a];
+				exit[a] = (box_min[a] - ball_max[a]) / motion[a];
+			} else if (box_min[a] > ball_max[a] || ball_min[a] > box_max[a]) {
+				return; //not moving on this axis and apart on it
+			} else {
+				enter[a] = -std::numeric_limits< float >::infinity();
+				exit[a] = std::numeric_limits< float >::infinity();
+			}
+		}
+		float t = std::max(enter[0], enter[1]);
+		if (t > std::min(exit[0], exit[1])) return; //axes overlap at different times: a miss
+		//(boxes already overlapping have t < 0; collide() deals with those)
+		consider(t, what, enter[1] > enter[0]);
+	};
+	sweep_box(PaddleBox, left_paddle, paddle_radius);
+	sweep_box(TopBlockBox, topBlock, block_radius);
+	sweep_box(BottomBlockBox, bottomBlock, block_radius);
+
+	//walls: time the ball's center reaches the inside edge of the court:
+	if (motion.y > 0.0f && hi.y >= wall_hi.y) consider((wall_hi.y - ball.y) / motion.y, TopWall, true);
+	if (motion.y < 0.0f && lo.y <= wall_lo.y) consider((wall_lo.y - ball.y) / motion.y, BottomWall, true);
+	if (motion.x > 0.0f && hi.x >= wall_hi.x) consider((wall_hi.x - ball.x) / motion.x, RightWall, false);
+
+	sweep_box(TopGateBox, topCenter, topRadius);
+	sweep_box(BottomGateBox, bottomCenter, bottomRadius);
+	sweep_box(TopGateBBox, topCenterB, topRadiusB);
+	sweep_box(BottomGateBBox, bottomCenterB, bottomRadiusB);
+
+	if (motion.x < 0.0f && lo.x <= wall_lo.x) consider((wall_lo.x - ball.x) / motion.x, LeftWall, false);
+
+	return best;
+}
+
+void PongSim::resolve(Contact const &contact) {
+	switch (contact.what) {
+		case PaddleBox: bounce(left_paddle, MOVING_PAD, contact.in_y); break;
+		case TopBlockBox: bounce(topBlock, STATIONARY_PAD, contact.in_y); break;
+		case BottomBlockBox: bounce(bottomBlock, STATIONARY_PAD, contact.in_y); break;
+		case TopGateBox: case BottomGateBox: case TopGateBBox: case BottomGateBBox: gate_contact(); break;
+		case TopWall: case BottomWall: case LeftWall: case RightWall: wall_contact(contact.what); break;
+		default: assert(0 && "resolve() called without a contact"); break;
+	}
+}
+
+//Reset ball position along with new gate
+void PongSim::moveBallLeft() {
+	ball = glm::vec2(-1.2f,left_paddle.y);
+	ball_velocity = glm::vec2(-1.0f, 0.0f);
+	if (ball.y < -court_radius.y + paddle_radius.y + ball_radius.y) ball.y = 1.1f * paddle_radius.y + ball_radius.y - court_radius.y;
+	if (ball.y > court_radius.y - paddle_radius.y - ball_radius.y) ball.y = -1.1f * paddle_radius.y - ball_radius.y + court_radius.y;
+
+}
+
+void PongSim::bounce(glm::vec2 const &paddle, int whichPad, bool in_y) {
+	glm::vec2 radius = paddle_radius;
+	if (whichPad == STATIONARY_PAD) radius = block_radius;
+
+	//Block always inverses
+	float difOffset = 1.0f;
+	if (whichPad == STATIONARY_PAD) difOffset = -1.0f;
+
+	if (in_y) {
+		//bounce in y direction:
+		if (ball.y > paddle.y) {
+			ball.y = paddle.y +(radius.y + ball_radius.y);
+			ball_velocity.y =  std::abs(ball_velocity.y);
+		} else {
+			ball.y = paddle.y - radius.y - ball_radius.y;
+			ball_velocity.y = -std::abs(ball_velocity.y);
+		}
+	} else {
+		//bounce in x direction:
+		if (ball.x > paddle.x) {
+			ball.x = paddle.x + (radius.x + ball_radius.x);
+			ball_velocity.x = std::abs(ball_velocity.x);
+		} else {
+			ball.x = paddle.x - radius.x - ball_radius.x;
+			ball_velocity.x = -std::abs(ball_velocity.x);
+		}
+		//warp y velocity based on offset from paddle center:
+		float vel = difOffset*(ball.y - paddle.y) / (radius.y + ball_radius.y);
+		ball_velocity.y = glm::mix(ball_velocity.y, vel, 0.75f);  //What? 
+	}
+}
+
+void PongSim::wall_contact(uint32_t wall) {
+	if (wall == TopWall) {
+		ball.y = court_radius.y - ball_radius.y;
+		if (ball_velocity.y > 0.0f) {
+			ball_velocity.y = -ball_velocity.y;
+		}
+	} else if (wall == BottomWall) {
+		ball.y = -court_radius.y + ball_radius.y;
+		if (ball_velocity.y < 0.0f) {
+			ball_velocity.y = -ball_velocity.y;
+		}
+	} else if (wall == RightWall) {
+		ball.x = court_radius.x - ball_radius.x;
+		if (ball_velocity.x > 0.0f) {
+			moveBallLeft();
+			left_score += 1; 
+			newGate(left_score);
+		}
+	} else if (wall == LeftWall) {
+		ball.x = -court_radius.x  + ball_radius.x;
+		if (ball_velocity.x < 0.0f) {
+			ball_velocity.x = -ball_velocity.x;
+		}
+	}
+}
+
+void PongSim::gate_contact() {
+	ball.x = gateX - ball_radius.x;
+	if (ball_velocity.x > 0.0f) {
+		left_lives--;
+		if (left_lives == 0) gameState = false; //If out of lives, restart the game
+		else {
+			moveBallLeft();
+			newGate(left_score); //Should reset gate even though they lost to avoid cheating
+		}
+		assert(left_lives > 0 || !gameState);
+	}
+}
+
+void PongSim::collide() {
+
+	//---- collision handling ----
+
+	//Which boxes the ball overlaps; every box is tested in one pass, then retested only after the ball moves:
+	uint32_t hits = overlap_mask();
+
+	//Sees purely if there is an overlap, ie collision, between balls and both gates
+	auto gateCollide = [this,&hits]() {
+		uint32_t gates = (1u << TopGateBox) | (1u << BottomGateBox); //After
+		if (useEarlier) gates |= (1u << TopGateBBox) | (1u << BottomGateBBox); //Before
+		return (hits & gates) != 0;
+	};
+
+	//paddles:
+	auto paddle_vs_ball = [this](glm::vec2 const &paddle, int whichPad) {
+		//compute area of overlap:
+		glm::vec2 radius = paddle_radius;
+		if (whichPad == STATIONARY_PAD) radius = block_radius;
+		glm::vec2 min = glm::max(paddle - radius, ball - ball_radius);
+		glm::vec2 max = glm::min(paddle + radius, ball + ball_radius);
+
+		//only called on overlap (see 'hits'):
+		assert(!(min.x > max.x || min.y > max.y));
+
+		//wider overlap in x => bounce in y direction:
+		bounce(paddle, whichPad, max.x - min.x > max.y - min.y);
+	};
+	if (hits & (1u << PaddleBox)) {
+		paddle_vs_ball(left_paddle, MOVING_PAD);
+		hits = overlap_mask();
+	}
+	if (hits & (1u << TopBlockBox)) {
+		paddle_vs_ball(topBlock, STATIONARY_PAD);
+		hits = overlap_mask();
+	}
+	if (hits & (1u << BottomBlockBox)) {
+		paddle_vs_ball(bottomBlock, STATIONARY_PAD);
+		hits = overlap_mask();
+	}
+	  
+	//court walls:
+	bool moved = false; //(walls move the ball and may make new gates, so 'hits' must be redone)
+	if (ball.y > court_radius.y - ball_radius.y) {
+		moved = true;
+		wall_contact(TopWall);
+	}
+	if (ball.y < -court_radius.y + ball_radius.y) {
+		moved = true;
+		wall_contact(BottomWall);
+	}
+
+	if (ball.x > court_radius.x - ball_radius.x) {
+		moved = true;
+		wall_contact(RightWall);
+	}
+	if (moved) hits = overlap_mask();
+	if (gateCollide()) {  //Checks hit with both gates
+		gate_contact();
+	}
+	if (ball.x < -court_radius.x + ball_radius.x) {
+		wall_contact(LeftWall);
+	}
+}
+
+void PongSim::step(uint32_t count) {
+	for (uint32_t i = 0; i < count && gameState; ++i) {
+		update(Tick);
+	}
+}
+
+uint64_t PongSim::state_hash() const {
+	//FNV-1a over the bits of everything that shows where the game is:
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	auto add = [&hash](void const *data, size_t size) {
+		for (size_t i = 0; i < size; ++i) {
+			hash = (hash ^ reinterpret_cast< uint8_t const * >(data)[i]) * 0x100000001b3ULL;
+		}
+	};
+	uint32_t state = (gameState ? 1 : 0);
+	add(&state, sizeof(state));
+	add(&left_score, sizeof(left_score));
+	add(&left_lives, sizeof(left_lives));
+	add(&left_paddle, sizeof(left_paddle));
+	add(&ball, sizeof(ball));
+	add(&ball_velocity, sizeof(ball_velocity));
+	add(&topBlock, sizeof(topBlock));
+	add(&bottomBlock, sizeof(bottomBlock));
+	add(&topCenter, sizeof(topCenter));
+	add(&bottomCenter, sizeof(bottomCenter));
+	add(&topCenterB, sizeof(topCenterB));
+	add(&bottomCenterB, sizeof(bottomCenterB));
+	return hash;
+}
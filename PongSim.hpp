@@ -0,0 +1,141 @@
+#pragma once
+
+#include "Pcg32.hpp"
+
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+
+/*
+ * PongSim holds the gameplay state for the gate game (ball, paddle, blocks, gates, score, lives)
+ *  and advances it. It touches no window or OpenGL state, so it can be stepped headless.
+ * PongMode wraps one of these and adds input + drawing.
+ */
+
+struct PongSim {
+	//the seed decides every random choice (gate placement), so equal seeds + equal input give equal games:
+	explicit PongSim(uint64_t seed);
+	//...seeded from the clock:
+	PongSim();
+
+	//fixed timestep used when stepping headless (seconds):
+	static constexpr float Tick = 1.0f / 120.0f;
+
+	//advance the game by 'elapsed' seconds (advance() then sweep()):
+	void update(float elapsed);
+	//move paddle and blocks:
+	void advance(float elapsed);
+	//move the ball for 'elapsed' seconds, stopping at each contact along its path to resolve it
+	// (so the ball can't pass through anything, however far it moves in one step; but only steps up to
+	//  MaxStep are sure to be carried out in full -- see dropped_steps):
+	void sweep(float elapsed);
+	//the part of sweep() after collide(): move the ball for 'remaining' seconds, stopping at each contact,
+	// when 'resolved' contacts have already been resolved this step (lets PongBatch hand a step back part way through):
+	void sweep_contacts(float remaining, uint32_t resolved);
+	//resolve contacts with whatever the ball currently overlaps (scoring, lives, new gates):
+	void collide();
+	//ball speed for the current score:
+	float speed_multiplier() const;
+	//...never more than this: the ball (|velocity| < 1.5) then moves under 10 units in a MaxStep (0.1 second) step,
+	// less than SweepLimit of the shortest bounces (0.6 units, between a block at its limit and the wall) add up to:
+	static constexpr float MaxSpeedMultiplier = 64.0f;
+	//advance the game by 'count' fixed ticks:
+	void step(uint32_t count);
+	//hash of score, lives, and the positions of everything (equal hashes -> same game state, for replays):
+	uint64_t state_hash() const;
+
+	//Boxes the ball is tested against in collide(), as bit indices of overlap_mask():
+	enum : uint32_t {
+		PaddleBox, TopBlockBox, BottomBlockBox,
+		TopGateBox, BottomGateBox, TopGateBBox, BottomGateBBox,
+		BoxCount
+	};
+	//bit i set if the ball currently overlaps box i (one pass of aabb_overlap_mask()):
+	uint32_t overlap_mask() const;
+	//...or if the box [ball_min, ball_max] overlaps box i:
+	uint32_t overlap_mask(glm::vec2 const &ball_min, glm::vec2 const &ball_max) const;
+
+	//Things the ball can run into while sweeping (the boxes above, then the court walls):
+	enum : uint32_t { TopWall = BoxCount, BottomWall, LeftWall, RightWall, NoContact };
+	struct Contact {
+		uint32_t what = NoContact;
+		float t = 1.0f; //fraction of the motion travelled before touching
+		bool in_y = false; //touched a top/bottom face (else a left/right face)
+		uint32_t near = 0; //bit per box or wall the ball's bounds reach at all during the motion
+	};
+	//earliest contact if the ball moved by 'motion':
+	Contact first_contact(glm::vec2 const &motion) const;
+	//bounce, score, or lose a life for a contact:
+	void resolve(Contact const &contact);
+	//most contacts sweep() will resolve in one step:
+	static constexpr uint32_t SweepLimit = 16;
+	//longest step sweep() is sure to finish (see MaxSpeedMultiplier); a longer step that runs into SweepLimit
+	// contacts drops the rest of its motion, which is counted here (running totals, for pong-sim to report):
+	static constexpr float MaxStep = 0.1f;
+	uint32_t dropped_steps = 0;
+	double dropped_time = 0.0; //seconds of ball motion dropped
+
+	//contact responses shared by collide() and resolve():
+	void moveBallLeft();
+	void bounce(glm::vec2 const &paddle, int whichPad, bool in_y);
+	void wall_contact(uint32_t wall);
+	void gate_contact();
+
+	//Function to create new gates based on current score
+	void newGate(unsigned int score);
+	uint64_t seed; //seed this game was created with
+	Pcg32 rng; //all of the game's randomness comes from here
+	//Gap will be set from a percentage of veritcal play area. Will be converted to actual coordinates based on play area
+	float minGap = 0.1f; //Can be set in testing
+	float maxGap = 0.33f; //Can be set in testing
+	float minBottom = 0.1f;
+	float maxTop =  1.0f - minBottom;
+
+	bool useEarlier = false; //Use a second gate before first
+	float defXOffset = 0.09f; //% offset between two gates
+	float yDivXOffset = 0.2f; // ratio offset added to the y gate offset regardless of additional offset related to gap
+
+	//Said actual coordinates
+	glm::vec2 topRadius;
+	glm::vec2 bottomRadius;
+	glm::vec2 topCenter;
+	glm::vec2 bottomCenter;
+
+	//"B"efore gate (earlier gate after level 10)
+	glm::vec2 topRadiusB;
+	glm::vec2 bottomRadiusB;
+	glm::vec2 topCenterB;
+	glm::vec2 bottomCenterB;
+
+	uint32_t levelPoints = 3;
+
+	//----- game state -----
+
+	bool gameState = true; //false once lives run out
+
+	glm::vec2 court_radius = glm::vec2(7.0f, 5.0f);
+	glm::vec2 paddle_radius = glm::vec2(0.2f, 1.0f);
+	glm::vec2 block_radius = glm::vec2(0.2f, 0.5f);
+	glm::vec2 ball_radius = glm::vec2(0.2f, 0.2f);
+	float gateWidth = 0.2f; //Can be changed, x axis
+	glm::vec2 wallObj_radius = glm::vec2(0.05f, 5.0f);
+
+	glm::vec2 left_paddle = glm::vec2(-court_radius.x + 0.5f, 0.0f);
+	glm::vec2 right_paddle = glm::vec2( court_radius.x - 0.5f, 0.0f);
+	float gateX = court_radius.x - 2.0f;
+	glm::vec2 leftWall = glm::vec2(-court_radius.x, 0.0f);
+	glm::vec2 topBlock = glm::vec2(0.0f, court_radius.y/2.f);
+	glm::vec2 bottomBlock = glm::vec2(0.0f, -court_radius.y/2.f);
+	glm::vec2 newRightBlock = glm::vec2(1.5f, -court_radius.y / 2.f);
+
+	bool moveBlocks = false;
+	float blockUpdate = .75f;
+	bool leftUp = false;
+	bool rightUp = true;
+
+	glm::vec2 ball = glm::vec2(0.0f, 0.0f);
+	glm::vec2 ball_velocity = glm::vec2(-1.0f, 0.0f);
+
+	uint32_t left_score = 0;
+	uint32_t left_lives = 45;
+};
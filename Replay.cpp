@@ -0,0 +1,86 @@
+#include "Replay.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <cassert>
+
+static char const HeaderMagic[8] = { 'p','o','n','g','r','e','c','1' };
+static char const FooterMagic[4] = { 'e','n','d','!' };
+static_assert(sizeof(ReplayLog::Update) == 8, "ReplayLog::Update is stored as two floats");
+
+ReplayRecorder::ReplayRecorder(std::string const &filename_, uint64_t seed) : filename(filename_) {
+	file.open(filename, std::ios::binary);
+	if (!file) throw std::runtime_error("Failed to open '" + filename + "' for writing.");
+	file.write(HeaderMagic, sizeof(HeaderMagic));
+	file.write(reinterpret_cast< char const * >(&seed), sizeof(seed));
+}
+
+void ReplayRecorder::record(float paddle_y, float elapsed) {
+	assert(!finished);
+	ReplayLog::Update update{ paddle_y, elapsed };
+	file.write(reinterpret_cast< char const * >(&update), sizeof(update));
+	updates += 1;
+}
+
+void ReplayRecorder::finish(PongSim const &sim) {
+	assert(!finished);
+	uint64_t hash = sim.state_hash();
+	file.write(FooterMagic, sizeof(FooterMagic));
+	file.write(reinterpret_cast< char const * >(&updates), sizeof(updates));
+	file.write(reinterpret_cast< char const * >(&hash), sizeof(hash));
+	file.close();
+	if (!file) throw std::runtime_error("Failed to write '" + filename + "'.");
+	finished = true;
+}
+
+ReplayLog load_replay(std::string const &filename) {
+	std::ifstream file(filename, std::ios::binary);
+	if (!file) throw std::runtime_error("Failed to open replay '" + filename + "'.");
+
+	std::vector< char > data;
+	file.seekg(0, std::ios::end);
+	data.resize(size_t(file.tellg()));
+	file.seekg(0, std::ios::beg);
+	file.read(data.data(), data.size());
+	if (!file) throw std::runtime_error("Failed to read replay '" + filename + "'.");
+
+	size_t const HeaderSize = sizeof(HeaderMagic) + 8;
+	size_t const FooterSize = sizeof(FooterMagic) + 8 + 8;
+	if (data.size() < HeaderSize || std::memcmp(data.data(), HeaderMagic, sizeof(HeaderMagic)) != 0) {
+		throw std::runtime_error("Replay '" + filename + "' doesn't start with a replay header.");
+	}
+
+	ReplayLog log;
+	std::memcpy(&log.seed, data.data() + sizeof(HeaderMagic), 8);
+
+	//footer is present if the file ends with one whose count matches the data in between:
+	size_t body = data.size() - HeaderSize;
+	if (body >= FooterSize) {
+		char const *footer = data.data() + data.size() - FooterSize;
+		uint64_t count = 0;
+		std::memcpy(&count, footer + sizeof(FooterMagic), 8);
+		if (std::memcmp(footer, FooterMagic, sizeof(FooterMagic)) == 0 && count * sizeof(ReplayLog::Update) == body - FooterSize) {
+			log.has_hash = true;
+			std::memcpy(&log.state_hash, footer + sizeof(FooterMagic) + 8, 8);
+			body -= FooterSize;
+		}
+	}
+
+	//(a crash can leave a partly-written update at the end; ignore it)
+	log.updates.resize(body / sizeof(ReplayLog::Update));
+	if (!log.updates.empty()) {
+		std::memcpy(log.updates.data(), data.data() + HeaderSize, log.updates.size() * sizeof(ReplayLog::Update));
+	}
+
+	return log;
+}
+
+PongSim run_replay(ReplayLog const &log) {
+	PongSim sim(log.seed);
+	for (auto const &update : log.updates) {
+		//(exactly what PongMode does: paddle from input, then update)
+		sim.left_paddle.y = update.paddle_y;
+		sim.update(update.elapsed);
+	}
+	return sim;
+}
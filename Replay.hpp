@@ -0,0 +1,54 @@
+#pragma once
+
+#include "PongSim.hpp"
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/*
+ * Session logs for PongSim: the seed, plus the paddle position and elapsed time
+ *  passed to every PongSim::update(). Feeding a log back through a PongSim built
+ *  with the same seed replays the game exactly (with the same build on the same platform),
+ *  so logs can reproduce reported bugs and check physics changes against real sessions.
+ *
+ * File format (little-endian):
+ *   "pongrec1" seed:u64
+ *   paddle_y:f32 elapsed:f32        -- once per update
+ *   "end!" updates:u64 state_hash:u64 -- written when recording finishes (missing if the game crashed)
+ */
+
+struct ReplayRecorder {
+	//starts the log (throws if the file can't be opened):
+	ReplayRecorder(std::string const &filename, uint64_t seed);
+	ReplayRecorder(ReplayRecorder const &) = delete;
+	ReplayRecorder &operator=(ReplayRecorder const &) = delete;
+
+	//call just before each PongSim::update(elapsed), with the paddle position it will use:
+	void record(float paddle_y, float elapsed);
+	//write the footer with the final state (call once, after the last update):
+	void finish(PongSim const &sim);
+
+	std::string filename;
+	std::ofstream file;
+	uint64_t updates = 0;
+	bool finished = false;
+};
+
+struct ReplayLog {
+	uint64_t seed = 0;
+	struct Update {
+		float paddle_y;
+		float elapsed;
+	};
+	std::vector< Update > updates;
+	bool has_hash = false; //false if the log has no footer
+	uint64_t state_hash = 0; //PongSim::state_hash() after the last update
+};
+
+//NOTE: load_replay will throw on error
+ReplayLog load_replay(std::string const &filename);
+
+//re-run a log from its seed (as fast as possible, no window needed):
+PongSim run_replay(ReplayLog const &log);
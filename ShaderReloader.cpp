@@ -0,0 +1,149 @@
+#include "ShaderReloader.hpp"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+ShaderReloader *ShaderReloader::current = nullptr;
+
+ShaderReloader::ShaderReloader(std::string const &directory_) : directory(directory_) {
+	gl_shader_directory = directory;
+
+#ifdef __linux__
+	//watch the directory rather than the files, since many editors save by writing a new file and renaming it over the old one:
+	inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (inotify >= 0 && inotify_add_watch(inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+		//(the directory may not exist until the first program writes its sources there)
+		mkdir(directory.c_str(), 0755);
+		if (inotify_add_watch(inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+			close(inotify);
+			inotify = -1;
+		}
+	}
+	if (inotify < 0) {
+		std::cerr << "NOTE: couldn't watch '" << directory << "' with inotify (" << std::strerror(errno) << "); checking modification times instead." << std::endl;
+	}
+#endif
+	last_scan = std::chrono::steady_clock::now();
+
+	std::cout << "Rebuilding shaders when their files in '" << directory << "' change." << std::endl;
+}
+
+ShaderReloader::~ShaderReloader() {
+#ifdef __linux__
+	if (inotify >= 0) close(inotify);
+	inotify = -1;
+#endif
+	gl_shader_directory = "";
+	if (current == this) current = nullptr;
+}
+
+void ShaderReloader::watch(void const *owner, std::string const &name,
+	std::function< GLPendingProgram() > const &start, std::function< bool(GLuint) > const &swap) {
+	//the program being registered may have just written its source files, so take any changes noticed so far
+	// before it is on the list (which keeps that from looking like an edit):
+	notice_changes();
+
+	watched.emplace_back();
+	Watched &w = watched.back();
+	w.owner = owner;
+	w.name = name;
+	w.start = start;
+	w.swap = swap;
+	w.modified = modified_time(name);
+}
+
+void ShaderReloader::unwatch(void const *owner) {
+	watched.erase(std::remove_if(watched.begin(), watched.end(), [owner](Watched const &w){
+		return w.owner == owner;
+	}), watched.end());
+}
+
+int64_t ShaderReloader::modified_time(std::string const &name) const {
+	int64_t latest = 0;
+	for (char const *extension : {".vert", ".frag"}) {
+		struct stat info;
+		if (stat((directory + "/" + name + extension).c_str(), &info) == 0) {
+			latest = std::max(latest, int64_t(info.st_mtime));
+		}
+	}
+	return latest;
+}
+
+void ShaderReloader::notice_changes() {
+	if (inotify >= 0) {
+#ifdef __linux__
+		alignas(struct inotify_event) char buffer[4096];
+		while (true) {
+			ssize_t count = read(inotify, buffer, sizeof(buffer));
+			if (count <= 0) break; //(EAGAIN: no more events)
+			for (char const *at = buffer; at < buffer + count; ) {
+				struct inotify_event const *event = reinterpret_cast< struct inotify_event const * >(at);
+				at += sizeof(struct inotify_event) + event->len;
+				if (event->len == 0) continue;
+				//mark the program 'name' if this was 'name.vert' or 'name.frag':
+				char const *file = event->name;
+				char const *dot = std::strrchr(file, '.');
+				if (!dot || (std::strcmp(dot, ".vert") != 0 && std::strcmp(dot, ".frag") != 0)) continue;
+				for (auto &w : watched) {
+					if (w.name.size() == size_t(dot - file) && w.name.compare(0, w.name.size(), file, dot - file) == 0) {
+						w.changed = true;
+					}
+				}
+			}
+		}
+#endif
+	} else {
+		auto now = std::chrono::steady_clock::now();
+		if (now - last_scan > std::chrono::milliseconds(250)) {
+			last_scan = now;
+			for (auto &w : watched) {
+				int64_t modified = modified_time(w.name);
+				if (modified != w.modified) {
+					w.modified = modified;
+					w.changed = true;
+				}
+			}
+		}
+	}
+}
+
+void ShaderReloader::update() {
+	notice_changes();
+
+	for (auto &w : watched) {
+		//start rebuilding changed programs (replacing any rebuild of an older version):
+		if (w.changed) {
+			w.changed = false;
+			std::cout << "Rebuilding '" << w.name << "'." << std::endl;
+			w.pending = w.start();
+		}
+
+		//swap in rebuilt programs that are ready:
+		if (w.pending.program && w.pending.ready()) {
+			GLuint program = 0;
+			try {
+				program = w.pending.get();
+			} catch (std::runtime_error &e) {
+				std::cerr << "Keeping the old '" << w.name << "' (" << e.what() << ")" << std::endl;
+				w.pending = GLPendingProgram(); //(deletes the failed program)
+				failures += 1;
+				continue;
+			}
+			if (w.swap(program)) {
+				reloads += 1;
+			} else {
+				glDeleteProgram(program);
+				failures += 1;
+			}
+		}
+	}
+}
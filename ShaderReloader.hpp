@@ -0,0 +1,71 @@
+#pragma once
+
+#include "gl_compile_program.hpp"
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/*
+ * ShaderReloader rebuilds shader programs when their source files change, so shaders can be edited while the game runs.
+ *
+ * Creating one sets gl_shader_directory, so programs built afterward come from '<directory>/<name>.vert' and '.frag'
+ *  (see gl_compile_program.hpp). Program wrappers (e.g., ColorRectProgram) register with ShaderReloader::current,
+ *  if there is one, giving a way to start their program and a way to swap in the rebuilt one.
+ *
+ * Changes are noticed with inotify on Linux (and by checking modification times about four times a second elsewhere).
+ * update() -- called between frames -- starts rebuilding changed programs (with gl_compile_program_async) and,
+ *  once a rebuilt program is ready, hands it to its wrapper, so no frame is ever drawn with a half-swapped program.
+ * A program that fails to compile is reported and the old one is kept.
+ *
+ * Needs a current OpenGL context for its whole lifetime.
+ */
+
+struct ShaderReloader {
+	ShaderReloader(std::string const &directory);
+	~ShaderReloader();
+	ShaderReloader(ShaderReloader const &) = delete;
+	ShaderReloader &operator=(ShaderReloader const &) = delete;
+
+	//the reloader program wrappers register with (null if shaders aren't being reloaded):
+	static ShaderReloader *current;
+
+	//rebuild the program called 'name' (with 'start') when its files change; 'swap' gets the rebuilt program
+	// and returns true if it took it (and deleted its old one) or false to have it deleted instead:
+	// ('owner' identifies this registration for unwatch; 'swap' must not call watch or unwatch)
+	void watch(void const *owner, std::string const &name,
+		std::function< GLPendingProgram() > const &start, std::function< bool(GLuint) > const &swap);
+	void unwatch(void const *owner);
+
+	//check for changed files and swap in any rebuilt programs that are ready:
+	void update();
+
+	std::string directory;
+
+	//counters:
+	uint32_t reloads = 0; //programs swapped in
+	uint32_t failures = 0; //rebuilds that failed to compile or were refused by their wrapper
+
+	//----- internals -----
+
+	struct Watched {
+		void const *owner;
+		std::string name;
+		std::function< GLPendingProgram() > start;
+		std::function< bool(GLuint) > swap;
+		GLPendingProgram pending; //rebuild in progress (if pending.program != 0)
+		bool changed = false; //files changed since the last rebuild started
+		int64_t modified = 0; //(when not using inotify) latest modification time of the two files
+	};
+	std::vector< Watched > watched;
+
+	int inotify = -1; //inotify descriptor (Linux only)
+	std::chrono::steady_clock::time_point last_scan; //(when not using inotify) last modification time check
+
+	//mark programs whose files changed:
+	void notice_changes();
+	//latest modification time of 'name's source files (0 if there are none):
+	int64_t modified_time(std::string const &name) const;
+};
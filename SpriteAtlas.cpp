@@ -0,0 +1,168 @@
+#include "SpriteAtlas.hpp"
+
+#include "PNGLoadBatch.hpp"
+#include "GLState.hpp"
+#include "gl_errors.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+SpriteAtlas::Skyline::Skyline(glm::uvec2 const &size_) : size(size_) {
+	spans.emplace_back(Span{0, 0, size.x});
+}
+
+bool SpriteAtlas::Skyline::place(glm::uvec2 const &rect, glm::uvec2 *at) {
+	assert(at);
+	//find the lowest spot (leftmost among equals) where the rectangle fits, starting at the left edge of some span:
+	uint32_t best_span = uint32_t(spans.size());
+	uint32_t best_y = size.y;
+	for (uint32_t i = 0; i < spans.size(); ++i) {
+		uint32_t x = spans[i].x;
+		if (x + rect.x > size.x) break;
+		//the rectangle rests on the highest span it covers:
+		uint32_t y = 0;
+		for (uint32_t j = i; j < spans.size() && spans[j].x < x + rect.x; ++j) {
+			y = std::max(y, spans[j].y);
+		}
+		if (y + rect.y <= size.y && y < best_y) {
+			best_y = y;
+			best_span = i;
+		}
+	}
+	if (best_span == spans.size()) return false;
+
+	//raise the skyline under the rectangle:
+	uint32_t x = spans[best_span].x;
+	uint32_t end = x + rect.x;
+	uint32_t last = best_span; //first span not entirely covered
+	while (last < spans.size() && spans[last].x + spans[last].width <= end) ++last;
+	if (last < spans.size() && spans[last].x < end) {
+		//(partly covered: keep its uncovered right part)
+		spans[last].width -= end - spans[last].x;
+		spans[last].x = end;
+	}
+	spans.erase(spans.begin() + best_span, spans.begin() + last);
+	spans.insert(spans.begin() + best_span, Span{x, best_y + rect.y, rect.x});
+
+	//merge with neighbors of the same height, to keep the list short:
+	for (uint32_t i = 0; i + 1 < spans.size(); ) {
+		if (spans[i].y == spans[i+1].y) {
+			spans[i].width += spans[i+1].width;
+			spans.erase(spans.begin() + i + 1);
+		} else {
+			++i;
+		}
+	}
+
+	*at = glm::uvec2(x, best_y);
+	return true;
+}
+
+SpriteAtlas::SpriteAtlas(std::vector< std::string > const &pngs, TextureCache *cache) {
+	std::vector< PNGLoadBatch::Image > images(pngs.size());
+	if (cache) {
+		//read everything from the cache (the largest level of each entry is the image itself):
+		for (uint32_t i = 0; i < pngs.size(); ++i) {
+			TextureCache::Entry entry = cache->fetch(pngs[i], LowerLeftOrigin);
+			if (entry.format == GL_RGBA8) {
+				TextureCache::Level const &level = entry.levels[0];
+				images[i].size = level.size;
+				images[i].data.resize(level.size.x * level.size.y);
+				std::memcpy(images[i].data.data(), level.data, level.bytes);
+			} else {
+				//(a BC1 entry can't be unpacked into the atlas, so decode the PNG after all)
+				load_png(pngs[i], &images[i].size, &images[i].data, LowerLeftOrigin);
+			}
+		}
+	} else {
+		//decode everything (in parallel):
+		PNGLoadBatch batch(pngs, LowerLeftOrigin);
+		batch.wait([&images](PNGLoadBatch::Image &image){
+			if (image.error != "") throw std::runtime_error(image.error);
+			images[image.index] = std::move(image);
+		});
+	}
+
+	//the white texel goes in last, as one more image:
+	uint32_t const white_index = uint32_t(images.size());
+	images.emplace_back();
+	images.back().size = glm::uvec2(1);
+	images.back().data.assign(1, glm::u8vec4(0xff, 0xff, 0xff, 0xff));
+
+	//tallest first packs tightest with a skyline:
+	std::vector< uint32_t > order(images.size());
+	for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&images](uint32_t a, uint32_t b){
+		return images[a].size.y > images[b].size.y;
+	});
+
+	//pack into the smallest power-of-two size that works (each sprite gets a 1-pixel border on all sides):
+	GLint max_size = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+	std::vector< glm::uvec2 > placed(images.size());
+	size = glm::uvec2(64);
+	while (true) {
+		Skyline skyline(size);
+		bool fit = true;
+		for (uint32_t i : order) {
+			if (!skyline.place(images[i].size + glm::uvec2(2), &placed[i])) {
+				fit = false;
+				break;
+			}
+		}
+		if (fit) break;
+		//grow the shorter side:
+		if (size.x <= size.y) size.x *= 2;
+		else size.y *= 2;
+		if (size.x > uint32_t(max_size) || size.y > uint32_t(max_size)) {
+			throw std::runtime_error("Sprites don't fit in a " + std::to_string(max_size) + "x" + std::to_string(max_size) + " atlas.");
+		}
+	}
+
+	//copy the images (and their edge pixels, into their borders) into place:
+	std::vector< glm::u8vec4 > pixels(size.x * size.y, glm::u8vec4(0x00, 0x00, 0x00, 0x00));
+	for (uint32_t i = 0; i < images.size(); ++i) {
+		PNGLoadBatch::Image const &image = images[i];
+		glm::uvec2 at = placed[i];
+		for (uint32_t y = 0; y < image.size.y + 2; ++y) {
+			uint32_t src_y = std::min(std::max(y, 1u) - 1, image.size.y - 1);
+			for (uint32_t x = 0; x < image.size.x + 2; ++x) {
+				uint32_t src_x = std::min(std::max(x, 1u) - 1, image.size.x - 1);
+				pixels[(at.y + y) * size.x + (at.x + x)] = image.data[src_y * image.size.x + src_x];
+			}
+		}
+
+		Sprite sprite;
+		sprite.size = image.size;
+		sprite.min_uv = glm::vec2(float(at.x + 1) / size.x, float(at.y + 1) / size.y);
+		sprite.max_uv = glm::vec2(float(at.x + 1 + image.size.x) / size.x, float(at.y + 1 + image.size.y) / size.y);
+		if (i == white_index) white = sprite;
+		else sprites[pngs[i]] = sprite;
+	}
+
+	glGenTextures(1, &texture);
+	gl_state.bind_texture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	gl_state.bind_texture(GL_TEXTURE_2D, 0);
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
+
+SpriteAtlas::~SpriteAtlas() {
+	glDeleteTextures(1, &texture);
+	texture = 0;
+	gl_state.forget(); //(deleting the texture unbinds it)
+}
+
+SpriteAtlas::Sprite const &SpriteAtlas::lookup(std::string const &png) const {
+	auto f = sprites.find(png);
+	if (f == sprites.end()) throw std::runtime_error("No sprite '" + png + "' in atlas.");
+	return f->second;
+}
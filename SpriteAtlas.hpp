@@ -0,0 +1,64 @@
+#pragma once
+
+#include "GL.hpp"
+#include "TextureCache.hpp"
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+/*
+ * SpriteAtlas packs many PNG images into one texture, so anything drawn from them
+ *  can share a texture binding (and, via SpriteBatch, a single draw call).
+ *
+ * Images are decoded in parallel (PNGLoadBatch) -- or, given a TextureCache, read from its entries, so later runs
+ *  skip decoding -- then sorted tallest-first and placed with a skyline packer;
+ *  the atlas starts small and doubles until everything fits. Each sprite gets a 1-pixel border copied
+ *  from its own edge pixels, so bilinear filtering at its edges never picks up a neighbor.
+ *
+ * Every atlas also packs a single white texel as 'white', so solid-colored shapes (drawn tinted)
+ *  can go in the same SpriteBatch as the images -- even in an atlas with no images at all.
+ *
+ * Needs a current OpenGL context; throws if an image can't be loaded or the atlas would exceed GL_MAX_TEXTURE_SIZE.
+ */
+
+struct SpriteAtlas {
+	//load and pack 'pngs' (each is then looked up by the filename given here):
+	// (with a 'cache', images come from its entries; it should have compression off, or opaque images get decoded anyway)
+	SpriteAtlas(std::vector< std::string > const &pngs, TextureCache *cache = nullptr);
+	~SpriteAtlas();
+	SpriteAtlas(SpriteAtlas const &) = delete;
+	SpriteAtlas &operator=(SpriteAtlas const &) = delete;
+
+	struct Sprite {
+		glm::vec2 min_uv, max_uv; //texture coordinates of the lower-left and upper-right corners
+		glm::uvec2 size; //in pixels
+	};
+
+	//throws if 'png' wasn't one of the images packed:
+	Sprite const &lookup(std::string const &png) const;
+
+	GLuint texture = 0; //RGBA8, linear filtering, no mipmaps (which would blend neighboring sprites)
+	glm::uvec2 size = glm::uvec2(0);
+	std::unordered_map< std::string, Sprite > sprites;
+	Sprite white; //1x1, opaque white (tint it to draw a solid rectangle)
+
+	//----- internals -----
+
+	//skyline packing: the atlas so far is described by the height of its top edge across its width,
+	// as runs of equal height; new rectangles sit on top of that edge, as low as possible:
+	struct Skyline {
+		Skyline(glm::uvec2 const &size);
+		//place a 'rect'-sized rectangle, returning its lower-left corner (false if it doesn't fit):
+		bool place(glm::uvec2 const &rect, glm::uvec2 *at);
+
+		glm::uvec2 size;
+		struct Span {
+			uint32_t x, y, width;
+		};
+		std::vector< Span > spans; //left to right, covering [0,size.x)
+	};
+};
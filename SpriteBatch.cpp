@@ -0,0 +1,100 @@
+#include "SpriteBatch.hpp"
+
+#include "GLState.hpp"
+#include "gl_errors.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+SpriteBatch::SpriteBatch(SpriteAtlas const &atlas_, GLPendingProgram &&color_texture) : atlas(atlas_),
+	color_texture_program(std::move(color_texture)) {
+	glGenVertexArrays(1, &vertex_buffer_for_color_texture_program);
+	gl_state.bind_vertex_array(vertex_buffer_for_color_texture_program);
+
+	//attributes point at the start of vertex_buffer; flush() picks the first vertex to draw instead of moving them:
+	// (the ring keeps the same buffer name when it grows, so this never needs redoing)
+	gl_state.bind_buffer(GL_ARRAY_BUFFER, vertex_buffer.buffer);
+
+	glVertexAttribPointer(
+		color_texture_program.Position_vec4, //attribute
+		2, //size
+		GL_FLOAT, //type
+		GL_FALSE, //normalized
+		sizeof(Vertex), //stride
+		(GLbyte *)0 + offsetof(Vertex, Position) //offset
+	);
+	glEnableVertexAttribArray(color_texture_program.Position_vec4);
+	//[Note that it is okay to bind a vec2 input to a vec4 attribute -- the w component will be filled with 1.0 automatically]
+
+	glVertexAttribPointer(
+		color_texture_program.Color_vec4, //attribute
+		4, //size
+		GL_UNSIGNED_BYTE, //type
+		GL_TRUE, //normalized
+		sizeof(Vertex), //stride
+		(GLbyte *)0 + offsetof(Vertex, Color) //offset
+	);
+	glEnableVertexAttribArray(color_texture_program.Color_vec4);
+
+	glVertexAttribPointer(
+		color_texture_program.TexCoord_vec2, //attribute
+		2, //size
+		GL_FLOAT, //type
+		GL_FALSE, //normalized
+		sizeof(Vertex), //stride
+		(GLbyte *)0 + offsetof(Vertex, TexCoord) //offset
+	);
+	glEnableVertexAttribArray(color_texture_program.TexCoord_vec2);
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
+
+SpriteBatch::~SpriteBatch() {
+	glDeleteVertexArrays(1, &vertex_buffer_for_color_texture_program);
+	vertex_buffer_for_color_texture_program = 0;
+	gl_state.forget(); //(deleting the vertex array unbinds it)
+	//(vertex_buffer frees its own buffer)
+}
+
+void SpriteBatch::draw(SpriteAtlas::Sprite const &sprite, glm::vec2 const &center, glm::vec2 const &radius, glm::u8vec4 const &tint) {
+	glm::vec2 min = center - radius;
+	glm::vec2 max = center + radius;
+	vertices.emplace_back(glm::vec2(min.x, min.y), tint, glm::vec2(sprite.min_uv.x, sprite.min_uv.y));
+	vertices.emplace_back(glm::vec2(max.x, min.y), tint, glm::vec2(sprite.max_uv.x, sprite.min_uv.y));
+	vertices.emplace_back(glm::vec2(max.x, max.y), tint, glm::vec2(sprite.max_uv.x, sprite.max_uv.y));
+
+	vertices.emplace_back(glm::vec2(min.x, min.y), tint, glm::vec2(sprite.min_uv.x, sprite.min_uv.y));
+	vertices.emplace_back(glm::vec2(max.x, max.y), tint, glm::vec2(sprite.max_uv.x, sprite.max_uv.y));
+	vertices.emplace_back(glm::vec2(min.x, max.y), tint, glm::vec2(sprite.min_uv.x, sprite.max_uv.y));
+}
+
+void SpriteBatch::flush() {
+	if (vertices.empty()) return;
+
+	//copy queued vertices into the next region of vertex_buffer:
+	size_t bytes = vertices.size() * sizeof(Vertex);
+	std::memcpy(vertex_buffer.map(bytes), vertices.data(), bytes);
+	GLintptr offset = vertex_buffer.unmap(bytes);
+
+	gl_state.bind_vertex_array(vertex_buffer_for_color_texture_program);
+
+	gl_state.enable(GL_BLEND);
+	gl_state.blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	gl_state.use_program(color_texture_program.program);
+
+	gl_state.active_texture(GL_TEXTURE0);
+	gl_state.bind_texture(GL_TEXTURE_2D, atlas.texture);
+
+	//every queued sprite, in one call:
+	glDrawArrays(GL_TRIANGLES, GLint(offset / sizeof(Vertex)), GLsizei(vertices.size()));
+	draw_calls += 1;
+	sprites_drawn += vertices.size() / 6;
+
+	vertex_buffer.fence();
+
+	vertices.clear(); //(keeps capacity for the next frame)
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+}
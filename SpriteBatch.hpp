@@ -0,0 +1,62 @@
+#pragma once
+
+#include "ColorTextureProgram.hpp"
+#include "SpriteAtlas.hpp"
+#include "BufferRing.hpp"
+
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/*
+ * SpriteBatch collects sprites from one SpriteAtlas and draws all of them with a single glDrawArrays.
+ *
+ * Usage, once per frame:
+ *   batch.draw(atlas.lookup("ball.png"), center, radius);   //...as many as needed, in back-to-front order
+ *   batch.flush(); //(between FrameUniforms set() and fence())
+ *
+ * Vertices are collected on the CPU (the vector's storage is kept between frames), then copied
+ *  into a BufferRing region at flush(); since the ring keeps regions vertex-aligned, the draw
+ *  just starts at that region's first vertex and the vertex array never needs re-pointing.
+ */
+
+struct SpriteBatch {
+	//'color_texture' is a ColorTextureProgram begun with ColorTextureProgram::start():
+	SpriteBatch(SpriteAtlas const &atlas, GLPendingProgram &&color_texture);
+	~SpriteBatch();
+	SpriteBatch(SpriteBatch const &) = delete;
+	SpriteBatch &operator=(SpriteBatch const &) = delete;
+
+	//queue 'sprite' covering [center-radius, center+radius], multiplied by 'tint':
+	void draw(SpriteAtlas::Sprite const &sprite, glm::vec2 const &center, glm::vec2 const &radius,
+		glm::u8vec4 const &tint = glm::u8vec4(0xff, 0xff, 0xff, 0xff));
+
+	//draw everything queued since the last flush (with alpha blending), then clear the queue:
+	// (positions are transformed by WORLD_TO_CLIP from the current FrameUniforms)
+	void flush();
+
+	SpriteAtlas const &atlas;
+
+	//counters (running totals):
+	uint64_t draw_calls = 0; //flush() calls that drew anything
+	uint64_t sprites_drawn = 0;
+
+	//----- internals -----
+
+	struct Vertex {
+		Vertex(glm::vec2 const &Position_, glm::u8vec4 const &Color_, glm::vec2 const &TexCoord_) :
+			Position(Position_), Color(Color_), TexCoord(TexCoord_) { }
+		glm::vec2 Position;
+		glm::u8vec4 Color;
+		glm::vec2 TexCoord;
+	};
+	static_assert(sizeof(Vertex) == 4*2 + 1*4 + 4*2, "SpriteBatch::Vertex should be packed");
+
+	std::vector< Vertex > vertices; //queued sprites, six vertices (two CCW triangles) each
+
+	ColorTextureProgram color_texture_program;
+	BufferRing vertex_buffer{GL_ARRAY_BUFFER, sizeof(Vertex)};
+	GLuint vertex_buffer_for_color_texture_program = 0;
+};
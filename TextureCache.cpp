@@ -0,0 +1,59 @@
+#include "TextureCache.hpp"
+
+//the parts of TextureCache that need OpenGL (fetch() and the cache entries are in TextureCacheFetch.cpp):
+
+#include "GLState.hpp"
+#include "gl_errors.hpp"
+
+#include <cstring>
+#include <iostream>
+
+GLuint TextureCache::load(std::string const &png, OriginLocation origin) {
+	//BC1 needs the driver's support, which can only be asked about with a context, so it is checked here:
+	if (compress && !compression_checked) {
+		compression_checked = true;
+		bool have_s3tc = false;
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (GLint i = 0; i < count; ++i) {
+			char const *name = reinterpret_cast< char const * >(glGetStringi(GL_EXTENSIONS, GLuint(i)));
+			if (name && std::strcmp(name, "GL_EXT_texture_compression_s3tc") == 0) have_s3tc = true;
+		}
+		if (!have_s3tc) {
+			std::cerr << "NOTE: no EXT_texture_compression_s3tc, so cached textures won't be compressed." << std::endl;
+			compress = false;
+		}
+	}
+
+	Entry fetched = fetch(png, origin);
+	return upload(fetched.format, fetched.levels);
+}
+
+GLuint TextureCache::upload(GLenum format, std::vector< Level > const &levels) {
+	GLuint tex = 0;
+	glGenTextures(1, &tex);
+	gl_state.bind_texture(GL_TEXTURE_2D, tex);
+
+	//every level is supplied, so there's nothing for glGenerateMipmap to do:
+	for (uint32_t i = 0; i < levels.size(); ++i) {
+		Level const &level = levels[i];
+		if (format == GL_RGBA8) {
+			glTexImage2D(GL_TEXTURE_2D, GLint(i), GL_RGBA8, level.size.x, level.size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, level.data);
+		} else {
+			glCompressedTexImage2D(GL_TEXTURE_2D, GLint(i), format, level.size.x, level.size.y, 0, level.bytes, level.data);
+		}
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(levels.size()) - 1);
+
+	//set filtering and wrapping parameters:
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	gl_state.bind_texture(GL_TEXTURE_2D, 0);
+
+	GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+	return tex;
+}
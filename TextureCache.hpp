@@ -0,0 +1,69 @@
+#pragma once
+
+#include "GL.hpp"
+#include "load_save_png.hpp"
+#include "MappedFile.hpp"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+//from EXT_texture_compression_s3tc (an extension, so not in GL.hpp):
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+
+/*
+ * TextureCache turns PNG files into mipmapped OpenGL textures, keeping the finished mip chains on disk
+ *  so later runs skip PNG decoding and mipmap generation entirely.
+ *
+ * Cache entries are named by a hash of the PNG's bytes (plus the settings below), so editing an image
+ *  just makes a new entry. Entries are read by memory-mapping them and uploading each level straight
+ *  from the mapping. Anything unreadable is rebuilt; delete the directory to clear the cache.
+ *
+ * With compression on, fully-opaque images are stored block-compressed as BC1 (DXT1: 4 bits per pixel,
+ *  an eighth the memory of RGBA8) if the driver has EXT_texture_compression_s3tc; other images stay RGBA8.
+ *
+ * Entries are in this machine's byte order, and aren't meant to be shipped.
+ *
+ * Needs a current OpenGL context to load() (which uploads, and checks for BC1 support the first time if compression is on).
+ * fetch() alone doesn't touch OpenGL -- it and the cache entries are in TextureCacheFetch.cpp, the only part pong-sim links --
+ *  so the cache can be checked headless ('pong-sim --texture-cache-check').
+ */
+
+struct TextureCache {
+	TextureCache(std::string const &directory = "texture-cache", bool compress = false);
+
+	//load (and cache) 'png' as a new texture, with filtering set up for mipmapping:
+	// (throws if the PNG can't be loaded; the caller owns the texture)
+	GLuint load(std::string const &png, OriginLocation origin = LowerLeftOrigin);
+
+	//a texture's levels, as stored in a cache entry:
+	struct Level {
+		glm::uvec2 size;
+		uint8_t const *data;
+		uint32_t bytes;
+	};
+	//everything load() uploads, read from the cache or built (and stored) if it isn't there:
+	struct Entry {
+		std::string filename; //cache entry
+		GLenum format = GL_RGBA8; //GL_RGBA8 or GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+		std::vector< Level > levels; //largest first, down to 1x1 (data points into 'mapped' or 'built')
+		std::unique_ptr< MappedFile > mapped; //the entry, if it was read from the cache
+		std::vector< std::vector< uint8_t > > built; //the levels, if they were just built
+	};
+	Entry fetch(std::string const &png, OriginLocation origin = LowerLeftOrigin);
+
+	std::string directory;
+	bool compress; //(the first load() turns this off if the driver can't do BC1)
+
+	//counters:
+	uint32_t hits = 0; //load()s served from the cache
+	uint32_t misses = 0; //load()s that decoded the PNG (and wrote a cache entry)
+
+	//----- internals -----
+
+	static GLuint upload(GLenum format, std::vector< Level > const &levels);
+	bool compression_checked = false; //has load() asked the driver about BC1 yet?
+};
@@ -0,0 +1,264 @@
+#include "TextureCache.hpp"
+
+//fetch() and the cache entries it reads and writes (decoding, mipmapping, BC1 encoding) -- none of which needs OpenGL,
+// so this file is all of TextureCache that pong-sim links; load() and upload() are in TextureCache.cpp.
+
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+//cache entry layout:
+// "texcach1", u32 format, u32 level count, then per level { u32 width, u32 height, u32 bytes }, then each level's bytes in order
+constexpr char Magic[8] = {'t','e','x','c','a','c','h','1'};
+constexpr uint32_t MaxLevels = 32;
+
+uint64_t fnv1a(uint64_t hash, uint8_t const *data, size_t size) {
+	for (size_t i = 0; i < size; ++i) {
+		hash = (hash ^ data[i]) * 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+//bytes a level of 'size' takes in 'format':
+uint32_t level_bytes(GLenum format, glm::uvec2 size) {
+	if (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT) {
+		return ((size.x + 3) / 4) * ((size.y + 3) / 4) * 8; //8 bytes per 4x4 block
+	} else {
+		return size.x * size.y * 4;
+	}
+}
+
+//next mip level: average each 2x2 square (the last row/column is reused at odd edges):
+std::vector< glm::u8vec4 > downsample(std::vector< glm::u8vec4 > const &from, glm::uvec2 from_size, glm::uvec2 const &size) {
+	std::vector< glm::u8vec4 > to(size.x * size.y);
+	for (uint32_t y = 0; y < size.y; ++y) {
+		uint32_t y0 = std::min(2 * y, from_size.y - 1), y1 = std::min(2 * y + 1, from_size.y - 1);
+		for (uint32_t x = 0; x < size.x; ++x) {
+			uint32_t x0 = std::min(2 * x, from_size.x - 1), x1 = std::min(2 * x + 1, from_size.x - 1);
+			glm::uvec4 sum = glm::uvec4(from[y0 * from_size.x + x0]) + glm::uvec4(from[y0 * from_size.x + x1])
+			               + glm::uvec4(from[y1 * from_size.x + x0]) + glm::uvec4(from[y1 * from_size.x + x1]);
+			to[y * size.x + x] = glm::u8vec4((sum + glm::uvec4(2)) / 4u);
+		}
+	}
+	return to;
+}
+
+//BC1 (DXT1) encoding: each 4x4 block becomes two 565 endpoint colors (taken from the block's bounding box)
+// plus a 2-bit index per pixel choosing among the endpoints and the two colors between them:
+std::vector< uint8_t > compress_bc1(std::vector< glm::u8vec4 > const &image, glm::uvec2 size) {
+	std::vector< uint8_t > blocks(level_bytes(GL_COMPRESSED_RGB_S3TC_DXT1_EXT, size));
+	auto to_565 = [](glm::ivec3 c) {
+		return uint16_t(((c.r >> 3) << 11) | ((c.g >> 2) << 5) | (c.b >> 3));
+	};
+	auto from_565 = [](uint16_t c) {
+		int r = (c >> 11) & 0x1f, g = (c >> 5) & 0x3f, b = c & 0x1f;
+		return glm::ivec3((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+	};
+	uint8_t *out = blocks.data();
+	for (uint32_t by = 0; by < size.y; by += 4) {
+		for (uint32_t bx = 0; bx < size.x; bx += 4) {
+			//gather the block (repeating edge pixels past the image):
+			glm::ivec3 px[16];
+			glm::ivec3 lo(255), hi(0);
+			for (uint32_t i = 0; i < 16; ++i) {
+				uint32_t x = std::min(bx + i % 4, size.x - 1);
+				uint32_t y = std::min(by + i / 4, size.y - 1);
+				px[i] = glm::ivec3(image[y * size.x + x]);
+				lo = glm::min(lo, px[i]);
+				hi = glm::max(hi, px[i]);
+			}
+			//pull the endpoints in a bit, since the in-between colors cover the extremes well enough:
+			glm::ivec3 inset = (hi - lo) / 16;
+			uint16_t c0 = to_565(hi - inset), c1 = to_565(lo + inset);
+			if (c0 < c1) std::swap(c0, c1); //(c0 > c1 selects the four-color mode)
+
+			uint32_t indices = 0;
+			if (c0 != c1) {
+				glm::ivec3 palette[4];
+				palette[0] = from_565(c0);
+				palette[1] = from_565(c1);
+				palette[2] = (2 * palette[0] + palette[1]) / 3;
+				palette[3] = (palette[0] + 2 * palette[1]) / 3;
+				for (uint32_t i = 0; i < 16; ++i) {
+					uint32_t best = 0;
+					int best_dist = 0x7fffffff;
+					for (uint32_t p = 0; p < 4; ++p) {
+						glm::ivec3 d = px[i] - palette[p];
+						int dist = d.r * d.r + d.g * d.g + d.b * d.b;
+						if (dist < best_dist) {
+							best_dist = dist;
+							best = p;
+						}
+					}
+					indices |= best << (2 * i);
+				}
+			} //(else the block is one color, and every index is 0)
+
+			out[0] = uint8_t(c0); out[1] = uint8_t(c0 >> 8);
+			out[2] = uint8_t(c1); out[3] = uint8_t(c1 >> 8);
+			out[4] = uint8_t(indices); out[5] = uint8_t(indices >> 8); out[6] = uint8_t(indices >> 16); out[7] = uint8_t(indices >> 24);
+			out += 8;
+		}
+	}
+	return blocks;
+}
+
+//read the levels of a cache entry (returns false if it's malformed):
+bool parse_entry(MappedFile const &file, GLenum *format, std::vector< TextureCache::Level > *levels) {
+	uint8_t const *at = file.data;
+	uint8_t const *end = file.data + file.size;
+	auto read_u32 = [&at](uint32_t *val) {
+		std::memcpy(val, at, 4);
+		at += 4;
+	};
+	if (size_t(end - at) < sizeof(Magic) + 8) return false;
+	if (std::memcmp(at, Magic, sizeof(Magic)) != 0) return false;
+	at += sizeof(Magic);
+	uint32_t count;
+	read_u32(format);
+	read_u32(&count);
+	if (*format != GL_RGBA8 && *format != GL_COMPRESSED_RGB_S3TC_DXT1_EXT) return false;
+	if (count == 0 || count > MaxLevels || size_t(end - at) < count * 12) return false;
+
+	levels->resize(count);
+	for (auto &level : *levels) {
+		read_u32(&level.size.x);
+		read_u32(&level.size.y);
+		read_u32(&level.bytes);
+		if (level.size.x == 0 || level.size.y == 0 || level.size.x > 65536 || level.size.y > 65536) return false;
+		if (level.bytes != level_bytes(*format, level.size)) return false;
+	}
+	for (auto &level : *levels) {
+		if (size_t(end - at) < level.bytes) return false;
+		level.data = at;
+		at += level.bytes;
+	}
+	return at == end;
+}
+
+} //namespace
+
+TextureCache::TextureCache(std::string const &directory_, bool compress_) : directory(directory_), compress(compress_) {
+	//make sure the cache directory exists:
+#ifdef _WIN32
+	int result = _mkdir(directory.c_str());
+#else
+	int result = mkdir(directory.c_str(), 0755);
+#endif
+	if (result != 0 && errno != EEXIST) {
+		throw std::runtime_error("Failed to create texture cache directory '" + directory + "'.");
+	}
+}
+
+TextureCache::Entry TextureCache::fetch(std::string const &png, OriginLocation origin) {
+	Entry fetched;
+
+	//entries are named for the PNG's contents and the settings that change what gets built from them:
+	uint64_t key = 0xcbf29ce484222325ULL;
+	{
+		MappedFile file(png);
+		key = fnv1a(key, file.data, file.size);
+	}
+	uint8_t settings[2] = { uint8_t(origin), uint8_t(compress) };
+	key = fnv1a(key, settings, sizeof(settings));
+	std::ostringstream entry_name;
+	entry_name << directory << "/" << std::hex << std::setw(16) << std::setfill('0') << key << ".tex";
+	std::string entry = entry_name.str();
+	fetched.filename = entry;
+
+	//warm: levels come straight from the mapped cache entry, if there is a good one:
+	try {
+		fetched.mapped.reset(new MappedFile(entry));
+	} catch (std::runtime_error &) {
+		//(not cached yet)
+	}
+	if (fetched.mapped) {
+		if (parse_entry(*fetched.mapped, &fetched.format, &fetched.levels)) {
+			hits += 1;
+			return fetched;
+		}
+		std::cerr << "Rebuilding bad texture cache entry '" << entry << "' (for '" << png << "')." << std::endl;
+		fetched.mapped.reset();
+		fetched.levels.clear();
+	}
+
+	//cold: decode, build the mip chain, and store it:
+	misses += 1;
+	glm::uvec2 size;
+	std::vector< glm::u8vec4 > image;
+	load_png(png, &size, &image, origin);
+
+	bool opaque = true;
+	for (auto const &px : image) {
+		if (px.a != 0xff) {
+			opaque = false;
+			break;
+		}
+	}
+	GLenum format = (compress && opaque ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_RGBA8);
+
+	std::vector< std::vector< uint8_t > > &level_data = fetched.built;
+	std::vector< Level > &levels = fetched.levels;
+	while (true) {
+		if (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT) {
+			level_data.emplace_back(compress_bc1(image, size));
+		} else {
+			level_data.emplace_back(reinterpret_cast< uint8_t const * >(image.data()), reinterpret_cast< uint8_t const * >(image.data() + image.size()));
+		}
+		levels.emplace_back();
+		levels.back().size = size;
+		levels.back().bytes = uint32_t(level_data.back().size());
+		if (size == glm::uvec2(1)) break;
+		glm::uvec2 next = glm::max(glm::uvec2(1), size / 2u);
+		image = downsample(image, size, next);
+		size = next;
+	}
+	for (uint32_t i = 0; i < levels.size(); ++i) {
+		levels[i].data = level_data[i].data();
+	}
+
+	{ //write to a temporary file and rename it into place, so a half-written entry is never read:
+		std::string temp = entry + ".tmp";
+		std::ofstream out(temp, std::ios::binary);
+		uint32_t count = uint32_t(levels.size());
+		out.write(Magic, sizeof(Magic));
+		out.write(reinterpret_cast< char const * >(&format), 4);
+		out.write(reinterpret_cast< char const * >(&count), 4);
+		for (auto const &level : levels) {
+			out.write(reinterpret_cast< char const * >(&level.size), 8);
+			out.write(reinterpret_cast< char const * >(&level.bytes), 4);
+		}
+		for (auto const &level : levels) {
+			out.write(reinterpret_cast< char const * >(level.data), level.bytes);
+		}
+		out.close();
+#ifdef _WIN32
+		std::remove(entry.c_str()); //(rename won't replace a bad entry on Windows)
+#endif
+		if (!out || std::rename(temp.c_str(), entry.c_str()) != 0) {
+			std::cerr << "NOTE: failed to write texture cache entry '" << entry << "'." << std::endl;
+			std::remove(temp.c_str());
+		}
+	}
+
+	fetched.format = format;
+	return fetched;
+}
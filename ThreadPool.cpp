@@ -0,0 +1,111 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+ThreadPool::ThreadPool(uint32_t threads) {
+	if (threads == 0) {
+		threads = std::max(2u, std::thread::hardware_concurrency()) - 1;
+	}
+	workers.reserve(threads);
+	for (uint32_t i = 0; i < threads; ++i) {
+		workers.emplace_back(&ThreadPool::worker_loop, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		quit = true;
+	}
+	work_cv.notify_all();
+	for (auto &worker : workers) {
+		worker.join();
+	}
+}
+
+ThreadPool &ThreadPool::shared() {
+	static ThreadPool pool;
+	return pool;
+}
+
+void ThreadPool::parallel_for(uint32_t count, std::function< void(uint32_t) > const &fn) {
+	if (count == 0) return;
+	if (count == 1) {
+		fn(0);
+		return;
+	}
+
+	Batch batch;
+	batch.fn = &fn;
+	batch.count = count;
+
+	std::unique_lock< std::mutex > lock(mutex);
+	batches.emplace_back(&batch);
+	work_cv.notify_all();
+
+	//help out, then wait for whatever the workers are still running:
+	work_on(batch, lock);
+	done_cv.wait(lock, [&batch](){ return batch.done == batch.count; });
+	lock.unlock();
+
+	if (batch.error) std::rethrow_exception(batch.error);
+}
+
+void ThreadPool::async_for(uint32_t count, std::function< void(uint32_t) > fn) {
+	if (count == 0) return;
+	assert(!workers.empty());
+
+	Batch *batch = new Batch;
+	batch->owned_fn = std::move(fn);
+	batch->fn = &batch->owned_fn;
+	batch->count = count;
+	batch->detached = true;
+
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		batches.emplace_back(batch);
+	}
+	work_cv.notify_all();
+}
+
+void ThreadPool::work_on(Batch &batch, std::unique_lock< std::mutex > &lock) {
+	assert(lock.owns_lock());
+	while (batch.next < batch.count) {
+		uint32_t index = batch.next++;
+		if (batch.next == batch.count) {
+			//nothing left to hand out, so nobody else needs to find this batch:
+			auto f = std::find(batches.begin(), batches.end(), &batch);
+			assert(f != batches.end());
+			batches.erase(f);
+		}
+		lock.unlock();
+		std::exception_ptr error;
+		try {
+			(*batch.fn)(index);
+		} catch (...) {
+			error = std::current_exception();
+		}
+		lock.lock();
+		if (error && !batch.error) batch.error = error;
+		batch.done += 1;
+		if (batch.done == batch.count) {
+			if (batch.detached) {
+				//(nobody is waiting on a detached batch, so its last index cleans it up)
+				assert(!batch.error && "async_for functions must not throw");
+				delete &batch;
+				return;
+			}
+			done_cv.notify_all();
+		}
+	}
+}
+
+void ThreadPool::worker_loop() {
+	std::unique_lock< std::mutex > lock(mutex);
+	while (true) {
+		work_cv.wait(lock, [this](){ return quit || !batches.empty(); });
+		if (batches.empty()) return; //(quit)
+		work_on(*batches.front(), lock);
+	}
+}
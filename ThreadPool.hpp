@@ -0,0 +1,64 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+/*
+ * ThreadPool runs data-parallel work on a fixed set of worker threads.
+ *
+ * parallel_for(count, fn) calls fn(0) ... fn(count-1), spread over the workers *and* the calling thread,
+ *  and returns once all of them are done. Because the caller helps, it is fine to call parallel_for
+ *  from inside a task (or from several threads at once): it never waits on work that nobody is running.
+ *
+ * async_for(count, fn) hands out indices the same way but doesn't wait (or help); use it for background work.
+ *
+ * Usage:
+ *   ThreadPool::shared().parallel_for(bands, [&](uint32_t band){ ...work on band... });
+ */
+
+struct ThreadPool {
+	//'threads' workers (0 = one per core, leaving one for the caller):
+	ThreadPool(uint32_t threads = 0);
+	~ThreadPool();
+	ThreadPool(ThreadPool const &) = delete;
+	ThreadPool &operator=(ThreadPool const &) = delete;
+
+	//run fn(i) for i in [0,count); if any call throws, the first exception is rethrown here once all calls are done:
+	void parallel_for(uint32_t count, std::function< void(uint32_t) > const &fn);
+	//start fn(i) for i in [0,count) on the workers and return right away (fn must not throw; catch inside it):
+	void async_for(uint32_t count, std::function< void(uint32_t) > fn);
+
+	//pool shared by the whole program (created on first use):
+	static ThreadPool &shared();
+
+	uint32_t size() const { return uint32_t(workers.size()); }
+
+	//----- internals -----
+
+	//one parallel_for or async_for call:
+	struct Batch {
+		std::function< void(uint32_t) > const *fn = nullptr;
+		std::function< void(uint32_t) > owned_fn; //(async_for: the batch owns its function, and the pool deletes it when done)
+		bool detached = false;
+		uint32_t count = 0;
+		uint32_t next = 0; //next index to hand out
+		uint32_t done = 0; //indices finished
+		std::exception_ptr error; //first exception thrown
+	};
+	//run indices of 'batch' until none are left to hand out (call with 'lock' held; returns with it held):
+	void work_on(Batch &batch, std::unique_lock< std::mutex > &lock);
+
+	void worker_loop();
+	std::vector< std::thread > workers;
+	std::mutex mutex;
+	std::condition_variable work_cv; //signalled when 'batches' gets work (or on quit)
+	std::condition_variable done_cv; //signalled when a batch finishes
+	std::deque< Batch * > batches; //batches with indices not yet handed out
+	bool quit = false;
+};
@@ -0,0 +1,335 @@
+#include "aabb.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+#if defined(__AVX2__)
+#define AABB_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AABB_SSE2
+#include <emmintrin.h>
+#endif
+
+char const *aabb_kernel_name() {
+#if defined(AABB_AVX2)
+	return "avx2";
+#elif defined(AABB_SSE2)
+	return "sse2";
+#else
+	return "scalar";
+#endif
+}
+
+//the single test every path below reproduces:
+static inline bool overlaps(float ball_min_x, float ball_min_y, float ball_max_x, float ball_max_y,
+	float min_x, float min_y, float max_x, float max_y) {
+	float lo_x = (min_x < ball_min_x ? ball_min_x : min_x); //glm::max
+	float lo_y = (min_y < ball_min_y ? ball_min_y : min_y);
+	float hi_x = (ball_max_x < max_x ? ball_max_x : max_x); //glm::min
+	float hi_y = (ball_max_y < max_y ? ball_max_y : max_y);
+	return !(lo_x > hi_x || lo_y > hi_y);
+}
+
+uint32_t aabb_overlap_mask_scalar(
+	glm::vec2 const &ball_min, glm::vec2 const &ball_max,
+	float const *min_x, float const *min_y, float const *max_x, float const *max_y,
+	uint32_t count) {
+	assert(count <= 32);
+	uint32_t mask = 0;
+	for (uint32_t i = 0; i < count; ++i) {
+		if (overlaps(ball_min.x, ball_min.y, ball_max.x, ball_max.y, min_x[i], min_y[i], max_x[i], max_y[i])) {
+			mask |= (1u << i);
+		}
+	}
+	return mask;
+}
+
+//NOTE: the vector paths use max/min instructions, which may pick the other zero when comparing +0 and -0;
+// the comparisons that follow treat those as equal, so the hit masks are unchanged.
+
+uint32_t aabb_overlap_mask(
+	glm::vec2 const &ball_min, glm::vec2 const &ball_max,
+	float const *min_x, float const *min_y, float const *max_x, float const *max_y,
+	uint32_t count) {
+	assert(count <= 32);
+	uint32_t mask = 0;
+	uint32_t i = 0;
+#if defined(AABB_AVX2)
+	__m256 const b_min_x = _mm256_set1_ps(ball_min.x);
+	__m256 const b_min_y = _mm256_set1_ps(ball_min.y);
+	__m256 const b_max_x = _mm256_set1_ps(ball_max.x);
+	__m256 const b_max_y = _mm256_set1_ps(ball_max.y);
+	for (; i + 8 <= count; i += 8) {
+		__m256 lo_x = _mm256_max_ps(_mm256_loadu_ps(min_x + i), b_min_x);
+		__m256 lo_y = _mm256_max_ps(_mm256_loadu_ps(min_y + i), b_min_y);
+		__m256 hi_x = _mm256_min_ps(_mm256_loadu_ps(max_x + i), b_max_x);
+		__m256 hi_y = _mm256_min_ps(_mm256_loadu_ps(max_y + i), b_max_y);
+		__m256 miss = _mm256_or_ps(_mm256_cmp_ps(lo_x, hi_x, _CMP_GT_OQ), _mm256_cmp_ps(lo_y, hi_y, _CMP_GT_OQ));
+		mask |= uint32_t(~_mm256_movemask_ps(miss) & 0xff) << i;
+	}
+#endif
+#if defined(AABB_AVX2) || defined(AABB_SSE2)
+	__m128 const s_min_x = _mm_set1_ps(ball_min.x);
+	__m128 const s_min_y = _mm_set1_ps(ball_min.y);
+	__m128 const s_max_x = _mm_set1_ps(ball_max.x);
+	__m128 const s_max_y = _mm_set1_ps(ball_max.y);
+	for (; i + 4 <= count; i += 4) {
+		__m128 lo_x = _mm_max_ps(_mm_loadu_ps(min_x + i), s_min_x);
+		__m128 lo_y = _mm_max_ps(_mm_loadu_ps(min_y + i), s_min_y);
+		__m128 hi_x = _mm_min_ps(_mm_loadu_ps(max_x + i), s_max_x);
+		__m128 hi_y = _mm_min_ps(_mm_loadu_ps(max_y + i), s_max_y);
+		__m128 miss = _mm_or_ps(_mm_cmpgt_ps(lo_x, hi_x), _mm_cmpgt_ps(lo_y, hi_y));
+		mask |= uint32_t(~_mm_movemask_ps(miss) & 0xf) << i;
+	}
+#endif
+	for (; i < count; ++i) {
+		if (overlaps(ball_min.x, ball_min.y, ball_max.x, ball_max.y, min_x[i], min_y[i], max_x[i], max_y[i])) {
+			mask |= (1u << i);
+		}
+	}
+	return mask;
+}
+
+//Lane-wise kernels: 'Balls' and 'Boxes' supply lane i's extents, so every layout shares one loop.
+
+struct ExtentBoxes {
+	float const *min_x, *min_y, *max_x, *max_y;
+	void get(uint32_t i, float *x0, float *y0, float *x1, float *y1) const {
+		*x0 = min_x[i]; *y0 = min_y[i]; *x1 = max_x[i]; *y1 = max_y[i];
+	}
+#if defined(AABB_AVX2)
+	void get8(uint32_t i, __m256 *x0, __m256 *y0, __m256 *x1, __m256 *y1) const {
+		*x0 = _mm256_loadu_ps(min_x + i); *y0 = _mm256_loadu_ps(min_y + i);
+		*x1 = _mm256_loadu_ps(max_x + i); *y1 = _mm256_loadu_ps(max_y + i);
+	}
+#endif
+#if defined(AABB_AVX2) || defined(AABB_SSE2)
+	void get4(uint32_t i, __m128 *x0, __m128 *y0, __m128 *x1, __m128 *y1) const {
+		*x0 = _mm_loadu_ps(min_x + i); *y0 = _mm_loadu_ps(min_y + i);
+		*x1 = _mm_loadu_ps(max_x + i); *y1 = _mm_loadu_ps(max_y + i);
+	}
+#endif
+};
+
+struct CenteredBoxes {
+	float const *center_x, *center_y;
+	glm::vec2 radius;
+	void get(uint32_t i, float *x0, float *y0, float *x1, float *y1) const {
+		*x0 = center_x[i] - radius.x; *y0 = center_y[i] - radius.y;
+		*x1 = center_x[i] + radius.x; *y1 = center_y[i] + radius.y;
+	}
+#if defined(AABB_AVX2)
+	void get8(uint32_t i, __m256 *x0, __m256 *y0, __m256 *x1, __m256 *y1) const {
+		__m256 x = _mm256_loadu_ps(center_x + i), y = _mm256_loadu_ps(center_y + i);
+		__m256 rx = _mm256_set1_ps(radius.x), ry = _mm256_set1_ps(radius.y);
+		*x0 = _mm256_sub_ps(x, rx); *y0 = _mm256_sub_ps(y, ry);
+		*x1 = _mm256_add_ps(x, rx); *y1 = _mm256_add_ps(y, ry);
+	}
+#endif
+#if defined(AABB_AVX2) || defined(AABB_SSE2)
+	void get4(uint32_t i, __m128 *x0, __m128 *y0, __m128 *x1, __m128 *y1) const {
+		__m128 x = _mm_loadu_ps(center_x + i), y = _mm_loadu_ps(center_y + i);
+		__m128 rx = _mm_set1_ps(radius.x), ry = _mm_set1_ps(radius.y);
+		*x0 = _mm_sub_ps(x, rx); *y0 = _mm_sub_ps(y, ry);
+		*x1 = _mm_add_ps(x, rx); *y1 = _mm_add_ps(y, ry);
+	}
+#endif
+};
+
+template< typename Balls, typename Boxes >
+static void overlap_lanes(uint32_t count, Balls const &balls, Boxes const &boxes, uint32_t bit, uint32_t *mask) {
+	uint32_t i = 0;
+#if defined(AABB_AVX2)
+	__m256i const bit8 = _mm256_set1_epi32(int(bit));
+	for (; i + 8 <= count; i += 8) {
+		__m256 a_x0, a_y0, a_x1, a_y1;
+		__m256 b_x0, b_y0, b_x1, b_y1;
+		boxes.get8(i, &b_x0, &b_y0, &b_x1, &b_y1);
+		balls.get8(i, &a_x0, &a_y0, &a_x1, &a_y1);
+		__m256 lo_x = _mm256_max_ps(b_x0, a_x0);
+		__m256 lo_y = _mm256_max_ps(b_y0, a_y0);
+		__m256 hi_x = _mm256_min_ps(b_x1, a_x1);
+		__m256 hi_y = _mm256_min_ps(b_y1, a_y1);
+		__m256i miss = _mm256_castps_si256(_mm256_or_ps(_mm256_cmp_ps(lo_x, hi_x, _CMP_GT_OQ), _mm256_cmp_ps(lo_y, hi_y, _CMP_GT_OQ)));
+		__m256i *out = reinterpret_cast< __m256i * >(mask + i);
+		_mm256_storeu_si256(out, _mm256_or_si256(_mm256_loadu_si256(out), _mm256_andnot_si256(miss, bit8)));
+	}
+#endif
+#if defined(AABB_AVX2) || defined(AABB_SSE2)
+	__m128i const bit4 = _mm_set1_epi32(int(bit));
+	for (; i + 4 <= count; i += 4) {
+		__m128 a_x0, a_y0, a_x1, a_y1;
+		__m128 b_x0, b_y0, b_x1, b_y1;
+		boxes.get4(i, &b_x0, &b_y0, &b_x1, &b_y1);
+		balls.get4(i, &a_x0, &a_y0, &a_x1, &a_y1);
+		__m128 lo_x = _mm_max_ps(b_x0, a_x0);
+		__m128 lo_y = _mm_max_ps(b_y0, a_y0);
+		__m128 hi_x = _mm_min_ps(b_x1, a_x1);
+		__m128 hi_y = _mm_min_ps(b_y1, a_y1);
+		__m128i miss = _mm_castps_si128(_mm_or_ps(_mm_cmpgt_ps(lo_x, hi_x), _mm_cmpgt_ps(lo_y, hi_y)));
+		__m128i *out = reinterpret_cast< __m128i * >(mask + i);
+		_mm_storeu_si128(out, _mm_or_si128(_mm_loadu_si128(out), _mm_andnot_si128(miss, bit4)));
+	}
+#endif
+	for (; i < count; ++i) {
+		float a_x0, a_y0, a_x1, a_y1;
+		float b_x0, b_y0, b_x1, b_y1;
+		boxes.get(i, &b_x0, &b_y0, &b_x1, &b_y1);
+		balls.get(i, &a_x0, &a_y0, &a_x1, &a_y1);
+		if (overlaps(a_x0, a_y0, a_x1, a_y1, b_x0, b_y0, b_x1, b_y1)) {
+			mask[i] |= bit;
+		}
+	}
+}
+
+void aabb_overlap_lanes(uint32_t count,
+	float const *ball_min_x, float const *ball_min_y, float const *ball_max_x, float const *ball_max_y,
+	float const *min_x, float const *min_y, float const *max_x, float const *max_y,
+	uint32_t bit, uint32_t *mask) {
+	ExtentBoxes balls{ball_min_x, ball_min_y, ball_max_x, ball_max_y};
+	ExtentBoxes boxes{min_x, min_y, max_x, max_y};
+	overlap_lanes(count, balls, boxes, bit, mask);
+}
+
+void aabb_overlap_lanes(uint32_t count,
+	float const *ball_min_x, float const *ball_min_y, float const *ball_max_x, float const *ball_max_y,
+	float const *center_x, float const *center_y, glm::vec2 const &radius,
+	uint32_t bit, uint32_t *mask) {
+	ExtentBoxes balls{ball_min_x, ball_min_y, ball_max_x, ball_max_y};
+	CenteredBoxes boxes{center_x, center_y, radius};
+	overlap_lanes(count, balls, boxes, bit, mask);
+}
+
+//the swept test every path below reproduces (PongSim::first_contact()'s sweep_box(), one axis at a time):
+static inline bool contact_axis(float motion, float ball_min, float ball_max, float box_min, float box_max, float *enter, float *exit) {
+	if (motion > 0.0f) {
+		*enter = (box_min - ball_max) / motion;
+		*exit = (box_max - ball_min) / motion;
+	} else if (motion < 0.0f) {
+		*enter = (box_max - ball_min) / motion;
+		*exit = (box_min - ball_max) / motion;
+	} else if (box_min > ball_max || ball_min > box_max) {
+		return false; //not moving on this axis and apart on it
+	} else {
+		*enter = -std::numeric_limits< float >::infinity();
+		*exit = std::numeric_limits< float >::infinity();
+	}
+	return true;
+}
+
+//NOTE: the vector paths compute every case and select, and use max/min instructions for std::max/min;
+// _mm_max_ps(a, b) is (a > b ? a : b) and _mm_min_ps(a, b) is (a < b ? a : b), so with the operands
+// ordered as below they pick exactly what std::max(enter_x, enter_y) and std::min(exit_x, exit_y) do.
+
+#if defined(AABB_AVX2)
+static inline __m256 select8(__m256 mask, __m256 a, __m256 b) {
+	return _mm256_or_ps(_mm256_and_ps(mask, a), _mm256_andnot_ps(mask, b));
+}
+
+static inline void contact_axis8(__m256 motion, __m256 ball_min, __m256 ball_max, __m256 box_min, __m256 box_max,
+	__m256 *enter, __m256 *exit, __m256 *apart) {
+	__m256 const zero = _mm256_setzero_ps();
+	__m256 const inf = _mm256_set1_ps(std::numeric_limits< float >::infinity());
+	__m256 a = _mm256_div_ps(_mm256_sub_ps(box_min, ball_max), motion);
+	__m256 b = _mm256_div_ps(_mm256_sub_ps(box_max, ball_min), motion);
+	__m256 pos = _mm256_cmp_ps(motion, zero, _CMP_GT_OQ);
+	__m256 neg = _mm256_cmp_ps(motion, zero, _CMP_LT_OQ);
+	*enter = select8(pos, a, select8(neg, b, _mm256_sub_ps(zero, inf)));
+	*exit = select8(pos, b, select8(neg, a, inf));
+	__m256 gap = _mm256_or_ps(_mm256_cmp_ps(box_min, ball_max, _CMP_GT_OQ), _mm256_cmp_ps(ball_min, box_max, _CMP_GT_OQ));
+	*apart = _mm256_andnot_ps(_mm256_or_ps(pos, neg), gap);
+}
+#endif
+
+#if defined(AABB_AVX2) || defined(AABB_SSE2)
+static inline __m128 select4(__m128 mask, __m128 a, __m128 b) {
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline void contact_axis4(__m128 motion, __m128 ball_min, __m128 ball_max, __m128 box_min, __m128 box_max,
+	__m128 *enter, __m128 *exit, __m128 *apart) {
+	__m128 const zero = _mm_setzero_ps();
+	__m128 const inf = _mm_set1_ps(std::numeric_limits< float >::infinity());
+	__m128 a = _mm_div_ps(_mm_sub_ps(box_min, ball_max), motion);
+	__m128 b = _mm_div_ps(_mm_sub_ps(box_max, ball_min), motion);
+	__m128 pos = _mm_cmpgt_ps(motion, zero);
+	__m128 neg = _mm_cmplt_ps(motion, zero);
+	*enter = select4(pos, a, select4(neg, b, _mm_sub_ps(zero, inf)));
+	*exit = select4(pos, b, select4(neg, a, inf));
+	__m128 gap = _mm_or_ps(_mm_cmpgt_ps(box_min, ball_max), _mm_cmpgt_ps(ball_min, box_max));
+	*apart = _mm_andnot_ps(_mm_or_ps(pos, neg), gap);
+}
+#endif
+
+void aabb_contact_lanes(uint32_t count,
+	float const *center_x, float const *center_y, glm::vec2 const &radius,
+	float const *motion_x, float const *motion_y,
+	float const *min_x, float const *min_y, float const *max_x, float const *max_y,
+	uint32_t bit, uint32_t const *mask, float *t, uint32_t *in_y) {
+	CenteredBoxes balls{center_x, center_y, radius};
+	ExtentBoxes boxes{min_x, min_y, max_x, max_y};
+	float const inf = std::numeric_limits< float >::infinity();
+	uint32_t i = 0;
+#if defined(AABB_AVX2)
+	__m256i const bit8 = _mm256_set1_epi32(int(bit));
+	__m256i const one8 = _mm256_set1_epi32(1);
+	__m256 const inf8 = _mm256_set1_ps(inf);
+	for (; i + 8 <= count; i += 8) {
+		__m256 a_x0, a_y0, a_x1, a_y1;
+		__m256 b_x0, b_y0, b_x1, b_y1;
+		balls.get8(i, &a_x0, &a_y0, &a_x1, &a_y1);
+		boxes.get8(i, &b_x0, &b_y0, &b_x1, &b_y1);
+		__m256 enter_x, exit_x, apart_x, enter_y, exit_y, apart_y;
+		contact_axis8(_mm256_loadu_ps(motion_x + i), a_x0, a_x1, b_x0, b_x1, &enter_x, &exit_x, &apart_x);
+		contact_axis8(_mm256_loadu_ps(motion_y + i), a_y0, a_y1, b_y0, b_y1, &enter_y, &exit_y, &apart_y);
+		__m256 enter = _mm256_max_ps(enter_y, enter_x);
+		__m256 exit = _mm256_min_ps(exit_y, exit_x);
+		__m256i bits = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast< __m256i const * >(mask + i)), bit8);
+		__m256 far = _mm256_castsi256_ps(_mm256_cmpeq_epi32(bits, _mm256_setzero_si256()));
+		__m256 miss = _mm256_or_ps(_mm256_or_ps(apart_x, apart_y), _mm256_or_ps(_mm256_cmp_ps(enter, exit, _CMP_GT_OQ), far));
+		_mm256_storeu_ps(t + i, select8(miss, inf8, enter));
+		__m256i later_y = _mm256_castps_si256(_mm256_cmp_ps(enter_y, enter_x, _CMP_GT_OQ));
+		_mm256_storeu_si256(reinterpret_cast< __m256i * >(in_y + i), _mm256_and_si256(later_y, one8));
+	}
+#endif
+#if defined(AABB_AVX2) || defined(AABB_SSE2)
+	__m128i const bit4 = _mm_set1_epi32(int(bit));
+	__m128i const one4 = _mm_set1_epi32(1);
+	__m128 const inf4 = _mm_set1_ps(inf);
+	for (; i + 4 <= count; i += 4) {
+		__m128 a_x0, a_y0, a_x1, a_y1;
+		__m128 b_x0, b_y0, b_x1, b_y1;
+		balls.get4(i, &a_x0, &a_y0, &a_x1, &a_y1);
+		boxes.get4(i, &b_x0, &b_y0, &b_x1, &b_y1);
+		__m128 enter_x, exit_x, apart_x, enter_y, exit_y, apart_y;
+		contact_axis4(_mm_loadu_ps(motion_x + i), a_x0, a_x1, b_x0, b_x1, &enter_x, &exit_x, &apart_x);
+		contact_axis4(_mm_loadu_ps(motion_y + i), a_y0, a_y1, b_y0, b_y1, &enter_y, &exit_y, &apart_y);
+		__m128 enter = _mm_max_ps(enter_y, enter_x);
+		__m128 exit = _mm_min_ps(exit_y, exit_x);
+		__m128i bits = _mm_and_si128(_mm_loadu_si128(reinterpret_cast< __m128i const * >(mask + i)), bit4);
+		__m128 far = _mm_castsi128_ps(_mm_cmpeq_epi32(bits, _mm_setzero_si128()));
+		__m128 miss = _mm_or_ps(_mm_or_ps(apart_x, apart_y), _mm_or_ps(_mm_cmpgt_ps(enter, exit), far));
+		_mm_storeu_ps(t + i, select4(miss, inf4, enter));
+		__m128i later_y = _mm_castps_si128(_mm_cmpgt_ps(enter_y, enter_x));
+		_mm_storeu_si128(reinterpret_cast< __m128i * >(in_y + i), _mm_and_si128(later_y, one4));
+	}
+#endif
+	for (; i < count; ++i) {
+		float a_x0, a_y0, a_x1, a_y1;
+		float b_x0, b_y0, b_x1, b_y1;
+		balls.get(i, &a_x0, &a_y0, &a_x1, &a_y1);
+		boxes.get(i, &b_x0, &b_y0, &b_x1, &b_y1);
+		float enter_x, exit_x, enter_y, exit_y;
+		t[i] = inf;
+		in_y[i] = 0;
+		if (!(mask[i] & bit)) continue;
+		if (!contact_axis(motion_x[i], a_x0, a_x1, b_x0, b_x1, &enter_x, &exit_x)) continue;
+		if (!contact_axis(motion_y[i], a_y0, a_y1, b_y0, b_y1, &enter_y, &exit_y)) continue;
+		float enter = std::max(enter_x, enter_y);
+		if (enter > std::min(exit_x, exit_y)) continue; //axes overlap at different times: a miss
+		t[i] = enter;
+		in_y[i] = (enter_y > enter_x ? 1 : 0);
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+
+/*
+ * Overlap and swept contact tests between axis-aligned boxes, vectorized when the build target allows
+ *  (AVX2 or SSE2, picked at compile time, with a scalar fallback).
+ *
+ * Boxes are passed as structure-of-arrays of their [min,max] extents.
+ * Overlap is decided exactly as PongSim's paddle/gate tests decide it:
+ *   lo = max(box.min, ball.min); hi = min(box.max, ball.max); overlap = !(lo.x > hi.x || lo.y > hi.y)
+ * so every path returns the same answers as the scalar code.
+ * Contact times are computed with the same float operations, in the same order, as PongSim::first_contact().
+ */
+
+//name of the implementation compiled in: "avx2", "sse2", or "scalar":
+char const *aabb_kernel_name();
+
+//test the box [ball_min, ball_max] against 'count' (at most 32) boxes;
+// bit i of the result is set if box i overlaps:
+uint32_t aabb_overlap_mask(
+	glm::vec2 const &ball_min, glm::vec2 const &ball_max,
+	float const *min_x, float const *min_y, float const *max_x, float const *max_y,
+	uint32_t count);
+
+//same as aabb_overlap_mask, but always scalar (reference for checking the vector paths):
+uint32_t aabb_overlap_mask_scalar(
+	glm::vec2 const &ball_min, glm::vec2 const &ball_max,
+	float const *min_x, float const *min_y, float const *max_x, float const *max_y,
+	uint32_t count);
+
+//lane-wise tests of many balls against one box each (balls given as [min,max] extents):
+// for every i < count, ORs 'bit' into mask[i] if box i overlaps ball i.
+//boxes given as [min,max] extents:
+void aabb_overlap_lanes(uint32_t count,
+	float const *ball_min_x, float const *ball_min_y, float const *ball_max_x, float const *ball_max_y,
+	float const *min_x, float const *min_y, float const *max_x, float const *max_y,
+	uint32_t bit, uint32_t *mask);
+//boxes given as centers and a shared radius (extents computed as center -/+ radius):
+void aabb_overlap_lanes(uint32_t count,
+	float const *ball_min_x, float const *ball_min_y, float const *ball_max_x, float const *ball_max_y,
+	float const *center_x, float const *center_y, glm::vec2 const &radius,
+	uint32_t bit, uint32_t *mask);
+
+//lane-wise swept test of many balls against one box each, as PongSim::first_contact() times a box:
+// for every i < count whose mask[i] has 'bit' set, ball i (centered at center_x/y[i], with 'radius') moves by
+// motion_x/y[i] toward box i ([min,max] extents); t[i] is the fraction of the motion at which they first overlap
+// on both axes, and in_y[i] is 1 if the y axis was the last to overlap (else 0).
+// lanes that never overlap along the motion (or don't have 'bit' set) get t[i] = +infinity.
+// (t[i] may be outside [0,1]; callers keep only the contacts within the motion, as PongSim does)
+void aabb_contact_lanes(uint32_t count,
+	float const *center_x, float const *center_y, glm::vec2 const &radius,
+	float const *motion_x, float const *motion_y,
+	float const *min_x, float const *min_y, float const *max_x, float const *max_y,
+	uint32_t bit, uint32_t const *mask, float *t, uint32_t *in_y);
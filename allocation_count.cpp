@@ -0,0 +1,71 @@
+#include "allocation_count.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+//Replacements for the global allocation functions that count calls and then use malloc/free.
+//(every other form of operator new and delete in the standard library forwards to these)
+
+static std::atomic< uint64_t > allocations(0);
+static thread_local uint64_t thread_allocations = 0;
+
+uint64_t allocation_count() {
+	return allocations.load(std::memory_order_relaxed);
+}
+
+uint64_t thread_allocation_count() {
+	return thread_allocations;
+}
+
+void *operator new(std::size_t size) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	thread_allocations += 1;
+	//(operator new(0) must still return a unique pointer)
+	while (true) {
+		if (void *ptr = std::malloc(size ? size : 1)) return ptr;
+		std::new_handler handler = std::get_new_handler();
+		if (!handler) throw std::bad_alloc();
+		handler();
+	}
+}
+
+void *operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void *operator new(std::size_t size, std::nothrow_t const &) noexcept {
+	try {
+		return operator new(size);
+	} catch (...) {
+		return nullptr;
+	}
+}
+
+void *operator new[](std::size_t size, std::nothrow_t const &) noexcept {
+	return operator new(size, std::nothrow);
+}
+
+void operator delete(void *ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void *ptr, std::nothrow_t const &) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::nothrow_t const &) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <stdint.h>
+
+//Number of heap allocations made through operator new / new[] so far, by any thread.
+// (allocation_count.cpp replaces the global operator new and delete to keep this count;
+//  link it in to use this, and subtract two readings to count the allocations made in between)
+uint64_t allocation_count();
+
+//...made by the calling thread only (so background threads, like screenshot writers, don't show up in a frame's count):
+uint64_t thread_allocation_count();
@@ -1,62 +1,376 @@
 #include "gl_compile_program.hpp"
 
+#include "MappedFile.hpp"
+#include "gl_errors.hpp"
+
+#include <SDL.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
 #include <vector>
 #include <string>
 #include <stdexcept>
 #include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <memory>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+std::string gl_program_cache_directory = "program-cache";
+std::string gl_shader_directory = "";
+
+//from ARB_get_program_binary (core only in OpenGL 4.1, so not in GL.hpp):
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+//from KHR_parallel_shader_compile:
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+
+namespace {
+
+//cache entry layout:
+// "progcch1", u32 binary format, u32 driver string length, driver string, then the binary (to the end of the file)
+constexpr char Magic[8] = {'p','r','o','g','c','c','h','1'};
+
+//optional entry points, looked up on first use (null if the driver doesn't have them):
+struct Driver {
+	//ARB_get_program_binary:
+	typedef void (APIENTRY *GetProgramBinary)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+	typedef void (APIENTRY *ProgramBinary)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+	typedef void (APIENTRY *ProgramParameteri)(GLuint program, GLenum pname, GLint value);
+	GetProgramBinary get_program_binary = nullptr;
+	ProgramBinary program_binary = nullptr;
+	ProgramParameteri program_parameteri = nullptr;
+	bool can_cache() const { return get_program_binary && program_binary && program_parameteri; }
+
+	//KHR_parallel_shader_compile (or the ARB version; both use the same tokens):
+	typedef void (APIENTRY *MaxShaderCompilerThreads)(GLuint count);
+	MaxShaderCompilerThreads max_shader_compiler_threads = nullptr;
+	bool parallel() const { return max_shader_compiler_threads; }
+
+	std::string identity; //vendor, renderer, and version strings; binaries only load on the driver that made them
+};
+
+Driver const &driver() {
+	static Driver d = [](){
+		Driver ret;
+
+		GLint major = 0, minor = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &major);
+		glGetIntegerv(GL_MINOR_VERSION, &minor);
+		bool has_program_binary = (major > 4 || (major == 4 && minor >= 1));
+		char const *parallel_threads = nullptr;
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (GLint i = 0; i < count; ++i) {
+			char const *name = reinterpret_cast< char const * >(glGetStringi(GL_EXTENSIONS, GLuint(i)));
+			if (!name) continue;
+			if (std::strcmp(name, "GL_ARB_get_program_binary") == 0) has_program_binary = true;
+			if (std::strcmp(name, "GL_KHR_parallel_shader_compile") == 0) parallel_threads = "glMaxShaderCompilerThreadsKHR";
+			if (std::strcmp(name, "GL_ARB_parallel_shader_compile") == 0 && !parallel_threads) parallel_threads = "glMaxShaderCompilerThreadsARB";
+		}
+
+		//(some drivers have the extension but no formats to save in)
+		GLint formats = 0;
+		if (has_program_binary) glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		if (has_program_binary && formats > 0) {
+			ret.get_program_binary = reinterpret_cast< Driver::GetProgramBinary >(SDL_GL_GetProcAddress("glGetProgramBinary"));
+			ret.program_binary = reinterpret_cast< Driver::ProgramBinary >(SDL_GL_GetProcAddress("glProgramBinary"));
+			ret.program_parameteri = reinterpret_cast< Driver::ProgramParameteri >(SDL_GL_GetProcAddress("glProgramParameteri"));
+		}
+		if (!ret.can_cache()) {
+			std::cerr << "NOTE: driver can't save program binaries, so shader programs won't be cached." << std::endl;
+		}
+
+		if (parallel_threads) {
+			ret.max_shader_compiler_threads = reinterpret_cast< Driver::MaxShaderCompilerThreads >(SDL_GL_GetProcAddress(parallel_threads));
+			//let the driver pick how many threads to compile with:
+			if (ret.max_shader_compiler_threads) ret.max_shader_compiler_threads(0xffffffff);
+		}
+
+		for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+			char const *str = reinterpret_cast< char const * >(glGetString(name));
+			ret.identity += (str ? str : "");
+			ret.identity += '\n';
+		}
+		return ret;
+	}();
+	return d;
+}
+
+uint64_t fnv1a(uint64_t hash, std::string const &data) {
+	for (char c : data) {
+		hash = (hash ^ uint8_t(c)) * 0x100000001b3ULL;
+	}
+	return hash;
+}
 
-static GLuint gl_compile_shader(GLenum type, std::string const &source) {
+bool make_directory(std::string const &directory) {
+#ifdef _WIN32
+	int result = _mkdir(directory.c_str());
+#else
+	int result = mkdir(directory.c_str(), 0755);
+#endif
+	return result == 0 || errno == EEXIST;
+}
+
+//use the text of 'filename' as 'source', or -- if there is no such file yet -- save 'source' there, to be edited:
+void source_from_file(std::string const &filename, std::string *source) {
+	std::ifstream in(filename, std::ios::binary);
+	if (in) {
+		std::ostringstream text;
+		text << in.rdbuf();
+		*source = text.str();
+	} else {
+		std::ofstream out(filename, std::ios::binary);
+		out << *source;
+		if (!out) std::cerr << "NOTE: failed to write shader source '" << filename << "'." << std::endl;
+	}
+}
+
+//make a program from the cache entry, if there is a usable one (otherwise returns 0):
+GLuint load_entry(std::string const &entry, Driver const &driver) {
+	std::unique_ptr< MappedFile > file;
+	try {
+		file.reset(new MappedFile(entry));
+	} catch (std::runtime_error &) {
+		return 0; //(not cached yet)
+	}
+	uint8_t const *at = file->data;
+	uint8_t const *end = file->data + file->size;
+	uint32_t format, driver_length;
+	if (size_t(end - at) < sizeof(Magic) + 8 || std::memcmp(at, Magic, sizeof(Magic)) != 0) return 0;
+	at += sizeof(Magic);
+	std::memcpy(&format, at, 4); at += 4;
+	std::memcpy(&driver_length, at, 4); at += 4;
+	if (size_t(end - at) < driver_length) return 0;
+	if (std::string(reinterpret_cast< char const * >(at), driver_length) != driver.identity) return 0; //(made by another driver)
+	at += driver_length;
+
+	//report errors from earlier code now, so the only error left afterward is glProgramBinary's own:
+	GL_ERRORS();
+
+	GLuint program = glCreateProgram();
+	driver.program_binary(program, GLenum(format), at, GLsizei(end - at));
+	GLenum binary_error = glGetError(); //(an unknown format is reported as GL_INVALID_ENUM)
+	GLint link_status = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &link_status);
+	if (binary_error != GL_NO_ERROR || link_status != GL_TRUE) {
+		//drivers may reject a binary for any reason (it's then just recompiled):
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+void save_entry(std::string const &entry, GLuint program, Driver const &driver) {
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) return;
+	std::vector< uint8_t > binary(length);
+	GLenum format = 0;
+	GLsizei written = 0;
+	driver.get_program_binary(program, length, &written, &format, binary.data());
+	if (written <= 0) return;
+
+	//write to a temporary file and rename it into place, so a half-written entry is never read:
+	std::string temp = entry + ".tmp";
+	std::ofstream out(temp, std::ios::binary);
+	uint32_t format32 = uint32_t(format);
+	uint32_t driver_length = uint32_t(driver.identity.size());
+	out.write(Magic, sizeof(Magic));
+	out.write(reinterpret_cast< char const * >(&format32), 4);
+	out.write(reinterpret_cast< char const * >(&driver_length), 4);
+	out.write(driver.identity.data(), driver_length);
+	out.write(reinterpret_cast< char const * >(binary.data()), written);
+	out.close();
+#ifdef _WIN32
+	std::remove(entry.c_str()); //(rename won't replace an old entry on Windows)
+#endif
+	if (!out || std::rename(temp.c_str(), entry.c_str()) != 0) {
+		std::cerr << "NOTE: failed to write program cache entry '" << entry << "'." << std::endl;
+		std::remove(temp.c_str());
+	}
+}
+
+} //namespace
+
+//print a shader's or program's info log:
+static void print_info_log(GLuint object, bool is_program) {
+	GLint info_log_length = 0;
+	if (is_program) glGetProgramiv(object, GL_INFO_LOG_LENGTH, &info_log_length);
+	else glGetShaderiv(object, GL_INFO_LOG_LENGTH, &info_log_length);
+	std::vector< GLchar > info_log(info_log_length + 1, 0);
+	GLsizei length = 0;
+	if (is_program) glGetProgramInfoLog(object, GLint(info_log.size()), &length, &info_log[0]);
+	else glGetShaderInfoLog(object, GLint(info_log.size()), &length, &info_log[0]);
+	std::cerr << "Info log: " << std::string(info_log.begin(), info_log.begin() + length);
+}
+
+static GLuint gl_start_shader(GLenum type, std::string const &source) {
 	GLuint shader = glCreateShader(type);
 	GLchar const *str = source.c_str();
 	GLint length = GLint(source.size());
 	glShaderSource(shader, 1, &str, &length);
 	glCompileShader(shader);
-	GLint compile_status = GL_FALSE;
-	glGetShaderiv(shader, GL_COMPILE_STATUS, &compile_status);
-	if (compile_status != GL_TRUE) {
-		std::cerr << "Failed to compile shader." << std::endl;
-		GLint info_log_length = 0;
-		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::vector< GLchar > info_log(info_log_length, 0);
-		GLsizei length = 0;
-		glGetShaderInfoLog(shader, GLint(info_log.size()), &length, &info_log[0]);
-		std::cerr << "Info log: " << std::string(info_log.begin(), info_log.begin() + length);
-		glDeleteShader(shader);
-		throw std::runtime_error("Failed to compile shader.");
-	}
+	//(compile status isn't checked until GLPendingProgram::get(), so this needn't wait for the compiler)
 	return shader;
 }
 
+GLPendingProgram gl_compile_program_async(
+	std::string const &vertex_shader_source_,
+	std::string const &fragment_shader_source_,
+	std::string const &name
+	) {
+	std::string vertex_shader_source = vertex_shader_source_;
+	std::string fragment_shader_source = fragment_shader_source_;
+	if (gl_shader_directory != "") {
+		if (make_directory(gl_shader_directory)) {
+			source_from_file(gl_shader_directory + "/" + name + ".vert", &vertex_shader_source);
+			source_from_file(gl_shader_directory + "/" + name + ".frag", &fragment_shader_source);
+		} else {
+			std::cerr << "NOTE: failed to create shader directory '" << gl_shader_directory << "'." << std::endl;
+		}
+	}
+
+	GLPendingProgram pending;
+	pending.name = name;
+	pending.before = std::chrono::high_resolution_clock::now();
+
+	Driver const &d = driver(); //(also turns on parallel compiling, if the driver has it)
+
+	//warm: use the binary from the cache entry, if there is a good one:
+	if (gl_program_cache_directory != "" && d.can_cache()) {
+		if (make_directory(gl_program_cache_directory)) {
+			uint64_t key = 0xcbf29ce484222325ULL;
+			key = fnv1a(key, vertex_shader_source);
+			key = fnv1a(key, std::string(1, '\0')); //(so moving text between the shaders changes the key)
+			key = fnv1a(key, fragment_shader_source);
+			std::ostringstream entry_name;
+			entry_name << gl_program_cache_directory << "/" << std::hex << std::setw(16) << std::setfill('0') << key << ".prog";
+			pending.cache_entry = entry_name.str();
+
+			if ((pending.program = load_entry(pending.cache_entry, d))) {
+				pending.from_cache = true;
+				return pending;
+			}
+		} else {
+			std::cerr << "NOTE: failed to create program cache directory '" << gl_program_cache_directory << "'." << std::endl;
+		}
+	}
+
+	//cold: start compiling and linking (results are checked -- and saved for next time -- by get()):
+	pending.vertex_shader = gl_start_shader(GL_VERTEX_SHADER, vertex_shader_source);
+	pending.fragment_shader = gl_start_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
+
+	pending.program = glCreateProgram();
+	glAttachShader(pending.program, pending.vertex_shader);
+	glAttachShader(pending.program, pending.fragment_shader);
+
+	//ask for a binary that can be saved (must be set before linking):
+	if (pending.cache_entry != "") d.program_parameteri(pending.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+	glLinkProgram(pending.program);
+
+	return pending;
+}
+
 GLuint gl_compile_program(
 	std::string const &vertex_shader_source,
-	std::string const &fragment_shader_source
+	std::string const &fragment_shader_source,
+	std::string const &name
 	) {
+	return gl_compile_program_async(vertex_shader_source, fragment_shader_source, name).get();
+}
 
-	GLuint vertex_shader = gl_compile_shader(GL_VERTEX_SHADER, vertex_shader_source);
-	GLuint fragment_shader = gl_compile_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
+GLPendingProgram::GLPendingProgram(GLPendingProgram &&other) {
+	*this = std::move(other);
+}
 
-	GLuint program = glCreateProgram();
-	glAttachShader(program, vertex_shader);
-	glAttachShader(program, fragment_shader);
+GLPendingProgram &GLPendingProgram::operator=(GLPendingProgram &&other) {
+	if (this != &other) {
+		clear();
+		name = std::move(other.name);
+		program = other.program;
+		vertex_shader = other.vertex_shader;
+		fragment_shader = other.fragment_shader;
+		cache_entry = std::move(other.cache_entry);
+		from_cache = other.from_cache;
+		before = other.before;
+		other.program = other.vertex_shader = other.fragment_shader = 0;
+	}
+	return *this;
+}
 
-	//shaders are reference counted so this makes sure they are freed after program is deleted:
-	glDeleteShader(vertex_shader);
-	glDeleteShader(fragment_shader);
+GLPendingProgram::~GLPendingProgram() {
+	clear();
+}
 
-	//link the shader program and throw errors if linking fails:
-	glLinkProgram(program);
-	GLint link_status = GL_FALSE;
-	glGetProgramiv(program, GL_LINK_STATUS, &link_status);
-	if (link_status != GL_TRUE) {
-		std::cerr << "Failed to link shader program." << std::endl;
-		GLint info_log_length = 0;
-		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &info_log_length);
-		std::vector< GLchar > info_log(info_log_length, 0);
-		GLsizei length = 0;
-		glGetProgramInfoLog(program, GLint(info_log.size()), &length, &info_log[0]);
-		std::cerr << "Info log: " << std::string(info_log.begin(), info_log.begin() + length);
-		throw std::runtime_error("failed to link program");
+void GLPendingProgram::clear() {
+	if (vertex_shader) glDeleteShader(vertex_shader);
+	if (fragment_shader) glDeleteShader(fragment_shader);
+	if (program) glDeleteProgram(program);
+	vertex_shader = fragment_shader = program = 0;
+}
+
+bool GLPendingProgram::ready() const {
+	if (!program || from_cache || !driver().parallel()) return true;
+	GLint done = GL_FALSE;
+	glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &done);
+	return done == GL_TRUE;
+}
+
+GLuint GLPendingProgram::get() {
+	if (!program) throw std::runtime_error("Program '" + name + "' was already taken (or never started).");
+
+	auto report = [this](char const *how) {
+		auto after = std::chrono::high_resolution_clock::now();
+		std::cout << name << ": " << how << " in " << std::chrono::duration< double, std::milli >(after - before).count() << " ms." << std::endl;
+	};
+
+	if (!from_cache) {
+		//(this is where the driver actually has to finish compiling and linking)
+		GLint link_status = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &link_status);
+		if (link_status != GL_TRUE) {
+			//a failed compile makes the link fail, so report that first:
+			for (GLuint shader : {vertex_shader, fragment_shader}) {
+				GLint compile_status = GL_FALSE;
+				glGetShaderiv(shader, GL_COMPILE_STATUS, &compile_status);
+				if (compile_status != GL_TRUE) {
+					std::cerr << "Failed to compile shader (for '" << name << "')." << std::endl;
+					print_info_log(shader, false);
+					throw std::runtime_error("Failed to compile shader.");
+				}
+			}
+			std::cerr << "Failed to link shader program '" << name << "'." << std::endl;
+			print_info_log(program, true);
+			throw std::runtime_error("failed to link program");
+		}
+		//(the program keeps what it needs from the shaders)
+		glDeleteShader(vertex_shader);
+		glDeleteShader(fragment_shader);
+		vertex_shader = fragment_shader = 0;
 	}
 
-	return program;
+	if (from_cache) {
+		report("loaded cached binary");
+	} else if (cache_entry != "") {
+		save_entry(cache_entry, program, driver());
+		report("compiled and linked (and cached)");
+	} else {
+		report("compiled and linked");
+	}
+
+	GLuint ret = program;
+	program = 0;
+	return ret;
 }
@@ -2,10 +2,59 @@
 
 #include "GL.hpp"
 
+#include <chrono>
 #include <string>
 
 //compiles+links an OpenGL shader program from source.
 // throws on compilation error.
+// 'name' labels the program in the line printed (to std::cout) with how long it took to get it.
 GLuint gl_compile_program(
 	std::string const &vertex_shader_source,
-	std::string const &fragment_shader_source);
+	std::string const &fragment_shader_source,
+	std::string const &name = "program");
+
+//a program that gl_compile_program_async has started building:
+struct GLPendingProgram {
+	GLPendingProgram() = default;
+	GLPendingProgram(GLPendingProgram &&);
+	GLPendingProgram &operator=(GLPendingProgram &&);
+	~GLPendingProgram(); //(deletes the program if get() was never called)
+
+	//true if get() won't have to wait for the driver:
+	// (only known with KHR_parallel_shader_compile; otherwise always true)
+	bool ready() const;
+
+	//wait for the program, check for errors (throws on compilation error, like gl_compile_program), and hand it over:
+	GLuint get();
+
+	//----- internals -----
+	std::string name;
+	GLuint program = 0;
+	GLuint vertex_shader = 0, fragment_shader = 0; //(kept until get(), to report compile errors)
+	std::string cache_entry; //where get() saves the linked binary ("" if not caching)
+	bool from_cache = false;
+	std::chrono::high_resolution_clock::time_point before; //when building started
+	void clear();
+};
+
+//starts compiling+linking without waiting for the driver to finish (or even to say whether it worked),
+// so that many programs can be started up front and compile together:
+//   GLPendingProgram a = gl_compile_program_async(...), b = gl_compile_program_async(...);
+//   GLuint program_a = a.get(), program_b = b.get();
+// (drivers with KHR_parallel_shader_compile build programs on their own threads; others still avoid
+//  a round trip per program, since no status is asked for until get())
+GLPendingProgram gl_compile_program_async(
+	std::string const &vertex_shader_source,
+	std::string const &fragment_shader_source,
+	std::string const &name = "program");
+
+//linked programs are kept on disk here as driver-specific binaries, so later runs can skip compiling:
+// (only if the driver supports ARB_get_program_binary; entries are named by a hash of the shader sources,
+//  and an entry made by a different driver -- vendor, renderer, or version -- is recompiled and replaced)
+// set to "" before creating programs to turn the cache off. (default: "program-cache")
+extern std::string gl_program_cache_directory;
+
+//if set, programs are built from '<directory>/<name>.vert' and '<name>.frag' instead of the sources passed in
+// (a file that doesn't exist yet is first written from the source passed in, so it can be edited;
+//  see ShaderReloader.hpp for rebuilding programs when their files change). (default: "", off)
+extern std::string gl_shader_directory;
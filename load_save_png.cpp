@@ -1,79 +1,115 @@
 #include "load_save_png.hpp"
 
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
+
 #include <png.h>
+#include <zlib.h>
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
 #include <vector>
 
 #define LOG_ERROR( X ) std::cerr << X << std::endl
 
 using std::vector;
 
-bool load_png(std::istream &from, unsigned int *width, unsigned int *height, vector< glm::u8vec4 > *data, OriginLocation origin);
-void save_png(std::ostream &to, unsigned int width, unsigned int height, glm::u8vec4 const *data, OriginLocation origin);
+static bool load_png(uint8_t const *bytes, size_t length, glm::uvec2 *size, std::function< glm::u8vec4 *(glm::uvec2) > const &destination, OriginLocation origin);
+void save_png(std::ostream &to, unsigned int width, unsigned int height, glm::u8vec4 const *data, OriginLocation origin, PNGEncoding const &encoding);
 
 void load_png(std::string filename, glm::uvec2 *size, std::vector< glm::u8vec4 > *data, OriginLocation origin) {
 	assert(size);
+	assert(data);
 
-	std::ifstream file(filename.c_str(), std::ios::binary);
-	if (!file) {
-		throw std::runtime_error("Failed to open PNG image file '" + filename + "'.");
-	}
-	if (!load_png(file, &size->x, &size->y, data, origin)) {
+	MappedFile file(filename);
+	bool loaded = load_png(file.data, file.size, size, [data](glm::uvec2 image_size) {
+		data->resize(size_t(image_size.x) * size_t(image_size.y));
+		return data->data();
+	}, origin);
+	if (!loaded) {
+		data->clear();
 		throw std::runtime_error("Failed to read PNG image from '" + filename + "'.");
 	}
 }
 
-void save_png(std::string filename, glm::uvec2 size, glm::u8vec4 const *data, OriginLocation origin) {
-	std::ofstream file(filename.c_str(), std::ios::binary);
-	save_png(file, size.x, size.y, data, origin);
-}
-
+void load_png(std::string filename, glm::uvec2 *size, glm::u8vec4 *data, size_t capacity, OriginLocation origin) {
+	assert(size);
+	assert(data);
 
-static void user_read_data(png_structp png_ptr, png_bytep data, png_size_t length) {
-	std::istream *from = reinterpret_cast< std::istream * >(png_get_io_ptr(png_ptr));
-	assert(from);
-	if (!from->read(reinterpret_cast< char * >(data), length)) {
-		png_error(png_ptr, "Error reading.");
+	MappedFile file(filename);
+	bool loaded = load_png(file.data, file.size, size, [data,capacity](glm::uvec2 image_size) {
+		return (size_t(image_size.x) * size_t(image_size.y) <= capacity ? data : nullptr);
+	}, origin);
+	if (!loaded) {
+		if (size_t(size->x) * size_t(size->y) > capacity) {
+			throw std::runtime_error("PNG image '" + filename + "' (" + std::to_string(size->x) + "x" + std::to_string(size->y) + ") doesn't fit in " + std::to_string(capacity) + " pixels.");
+		}
+		throw std::runtime_error("Failed to read PNG image from '" + filename + "'.");
 	}
 }
 
-static void user_write_data(png_structp png_ptr, png_bytep data, png_size_t length) {
-	std::ostream *to = reinterpret_cast< std::ostream * >(png_get_io_ptr(png_ptr));
-	assert(to);
-	if (!to->write(reinterpret_cast< char * >(data), length)) {
-		png_error(png_ptr, "Error writing.");
+glm::uvec2 png_size(std::string filename) {
+	MappedFile file(filename);
+	glm::uvec2 size;
+	//(reads the header, then stops, since there's nowhere to put pixels)
+	load_png(file.data, file.size, &size, [](glm::uvec2) -> glm::u8vec4 * { return nullptr; }, LowerLeftOrigin);
+	if (size == glm::uvec2(0)) {
+		throw std::runtime_error("Failed to read PNG image header from '" + filename + "'.");
 	}
+	return size;
 }
 
-static void user_flush_data(png_structp png_ptr) {
-	std::ostream *to = reinterpret_cast< std::ostream * >(png_get_io_ptr(png_ptr));
-	assert(to);
-	if (!to->flush()) {
-		png_error(png_ptr, "Error flushing.");
+void save_png(std::string filename, glm::uvec2 size, glm::u8vec4 const *data, OriginLocation origin, PNGEncoding const &encoding) {
+	std::ofstream file(filename.c_str(), std::ios::binary);
+	try {
+		save_png(file, size.x, size.y, data, origin, encoding);
+	} catch (std::exception const &e) {
+		LOG_ERROR("Error writing png: " << e.what());
 	}
 }
 
 
-bool load_png(std::istream &from, unsigned int *width, unsigned int *height, vector< glm::u8vec4 > *data, OriginLocation origin) {
-	assert(data);
-	uint32_t local_width, local_height;
-	if (width == nullptr) width = &local_width;
-	if (height == nullptr) height = &local_height;
-	*width = *height = 0;
-	data->clear();
+//----- loading -----
+
+//the rest of a PNG file, as read by libpng:
+struct PNGBytes {
+	uint8_t const *data;
+	size_t size;
+};
+
+static void user_read_data(png_structp png_ptr, png_bytep data, png_size_t length) {
+	PNGBytes *from = reinterpret_cast< PNGBytes * >(png_get_io_ptr(png_ptr));
+	assert(from);
+	if (length > from->size) {
+		png_error(png_ptr, "Error reading.");
+	}
+	std::memcpy(data, from->data, length);
+	from->data += length;
+	from->size -= length;
+}
+
+//decode the PNG in 'bytes', with 'destination' saying where to put the pixels once the size is known
+// (returns false on error, or if 'destination' returns nullptr; '*size' is set either way once the header is read):
+static bool load_png(uint8_t const *bytes, size_t length, glm::uvec2 *size, std::function< glm::u8vec4 *(glm::uvec2) > const &destination, OriginLocation origin) {
+	assert(size);
+	*size = glm::uvec2(0);
+	PNGBytes from{bytes, length};
 	//..... load file ......
 	//Load a png file, as per the libpng docs:
 	png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, (png_voidp)NULL, (png_error_ptr)NULL, (png_error_ptr)NULL);
 
-	png_set_read_fn(png, &from, user_read_data);
-
 	if (!png) {
 		LOG_ERROR("  cannot alloc read struct.");
 		return false;
 	}
+	png_set_read_fn(png, &from, user_read_data);
+
 	png_infop info = png_create_info_struct(png);
 	if (!info) {
 		LOG_ERROR("  cannot alloc info struct.");
@@ -85,13 +121,18 @@ bool load_png(std::istream &from, unsigned int *width, unsigned int *height, vec
 		LOG_ERROR("  png interal error.");
 		png_destroy_read_struct(&png, &info, (png_infopp)NULL);
 		if (row_pointers != NULL) delete[] row_pointers;
-		data->clear();
 		return false;
 	}
 	//not needed with custom read/write functions: png_init_io(png, NULL);
 	png_read_info(png, info);
 	unsigned int w = png_get_image_width(png, info);
 	unsigned int h = png_get_image_height(png, info);
+	*size = glm::uvec2(w, h);
+	glm::u8vec4 *data = destination(*size);
+	if (!data) {
+		png_destroy_read_struct(&png, &info, NULL);
+		return false;
+	}
 	if (png_get_color_type(png, info) == PNG_COLOR_TYPE_PALETTE)
 		png_set_palette_to_rgb(png);
 	if (png_get_color_type(png, info) == PNG_COLOR_TYPE_GRAY || png_get_color_type(png, info) == PNG_COLOR_TYPE_GRAY_ALPHA)
@@ -109,67 +150,233 @@ bool load_png(std::istream &from, unsigned int *width, unsigned int *height, vec
 	//Make sure it's the format we think it is...
 	assert(rowbytes == w*sizeof(uint32_t));
 
-	data->resize(w*h);
+	//rows are decoded straight into 'data':
 	row_pointers = new png_bytep[h];
 	for (unsigned int r = 0; r < h; ++r) {
 		if (origin == LowerLeftOrigin) {
-			row_pointers[h-1-r] = (png_bytep)(&(*data)[r*w]);
+			row_pointers[h-1-r] = (png_bytep)(&data[size_t(r)*w]);
 		} else {
-			row_pointers[r] = (png_bytep)(&(*data)[r*w]);
+			row_pointers[r] = (png_bytep)(&data[size_t(r)*w]);
 		}
 	}
 	png_read_image(png, row_pointers);
 	png_destroy_read_struct(&png, &info, NULL);
 	delete[] row_pointers;
 
-	*width = w;
-	*height = h;
 	return true;
 }
 
 
-void save_png(std::ostream &to, unsigned int width, unsigned int height, glm::u8vec4 const *data, OriginLocation origin) {
-//After the libpng example.c
-	png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-
-	png_set_write_fn(png_ptr, &to, user_write_data, user_flush_data);
+//----- saving -----
+//PNG files are written directly (signature, IHDR, IDATs, IEND) rather than through libpng,
+// so that the image can be filtered and deflated in bands on several threads at once.
+//Each band is deflated on its own -- primed with the 32k of data before it, as pigz does, so little compression is lost --
+// and ends on a byte boundary (Z_SYNC_FLUSH), so the bands concatenate into one valid zlib stream; each becomes an IDAT chunk.
 
-	if (png_ptr == NULL) {
-		LOG_ERROR("Can't create write struct.");
-		return;
-	}
+static void put_u32(uint8_t *to, uint32_t val) {
+	to[0] = uint8_t(val >> 24);
+	to[1] = uint8_t(val >> 16);
+	to[2] = uint8_t(val >> 8);
+	to[3] = uint8_t(val);
+}
 
-	png_infop info_ptr = png_create_info_struct(png_ptr);
-	if (info_ptr == NULL) {
-		png_destroy_write_struct(&png_ptr, NULL);
-		LOG_ERROR("Can't craete info pointer");
-		return;
+//filter 'bytes' of 'row' (with 'prior' the row above, or nullptr for the first row) into 'out' (type byte + filtered bytes):
+static void filter_row(PNGFilter filter, uint8_t const *row, uint8_t const *prior, size_t bytes, uint8_t *out) {
+	constexpr size_t bpp = 4; //bytes per pixel (8-bit RGBA)
+	uint8_t *to = out + 1;
+	if (filter == PNGFilterNone) {
+		out[0] = 0;
+		std::memcpy(to, row, bytes);
+	} else if (filter == PNGFilterSub) {
+		out[0] = 1;
+		for (size_t i = 0; i < bpp; ++i) to[i] = row[i];
+		for (size_t i = bpp; i < bytes; ++i) to[i] = uint8_t(row[i] - row[i-bpp]);
+	} else if (filter == PNGFilterUp) {
+		out[0] = 2;
+		if (!prior) {
+			std::memcpy(to, row, bytes);
+		} else {
+			for (size_t i = 0; i < bytes; ++i) to[i] = uint8_t(row[i] - prior[i]);
+		}
+	} else if (filter == PNGFilterAverage) {
+		out[0] = 3;
+		for (size_t i = 0; i < bytes; ++i) {
+			uint32_t a = (i >= bpp ? row[i-bpp] : 0);
+			uint32_t b = (prior ? prior[i] : 0);
+			to[i] = uint8_t(row[i] - ((a + b) >> 1));
+		}
+	} else if (filter == PNGFilterPaeth) {
+		out[0] = 4;
+		for (size_t i = 0; i < bytes; ++i) {
+			int a = (i >= bpp ? row[i-bpp] : 0);
+			int b = (prior ? prior[i] : 0);
+			int c = (prior && i >= bpp ? prior[i-bpp] : 0);
+			int pa = std::abs(b - c);
+			int pb = std::abs(a - c);
+			int pc = std::abs(a + b - 2 * c);
+			int pred = (pa <= pb && pa <= pc ? a : (pb <= pc ? b : c));
+			to[i] = uint8_t(row[i] - pred);
+		}
+	} else { assert(filter == PNGFilterAdaptive);
+		//try each filter, keeping the one with the smallest sum of (signed) magnitudes:
+		static thread_local std::vector< uint8_t > scratch;
+		scratch.resize(bytes + 1);
+		//(stops counting once past 'limit', since that filter won't be picked anyway)
+		auto cost = [bytes](uint8_t const *filtered, uint64_t limit) {
+			uint64_t sum = 0;
+			for (size_t i = 1; i <= bytes && sum < limit; i += 256) {
+				size_t end = std::min(bytes + 1, i + 256);
+				for (size_t j = i; j < end; ++j) sum += uint32_t(std::abs(int(int8_t(filtered[j]))));
+			}
+			return sum;
+		};
+		filter_row(PNGFilterNone, row, prior, bytes, out);
+		uint64_t best = cost(out, UINT64_MAX);
+		for (PNGFilter f : { PNGFilterSub, PNGFilterUp, PNGFilterAverage, PNGFilterPaeth }) {
+			filter_row(f, row, prior, bytes, scratch.data());
+			uint64_t c = cost(scratch.data(), best);
+			if (c < best) {
+				best = c;
+				std::memcpy(out, scratch.data(), bytes + 1);
+			}
+		}
 	}
+}
 
-	if (setjmp(png_jmpbuf(png_ptr))) {
-		png_destroy_write_struct(&png_ptr, &info_ptr);
-		LOG_ERROR("Error writing png.");
+void save_png(std::ostream &to, unsigned int width, unsigned int height, glm::u8vec4 const *data, OriginLocation origin, PNGEncoding const &encoding) {
+	if (width == 0 || height == 0) {
+		LOG_ERROR("Can't save an empty png.");
 		return;
 	}
+	int level = std::max(0, std::min(9, encoding.level));
+	size_t row_bytes = size_t(width) * 4;
+	size_t filtered_row_bytes = row_bytes + 1;
 
-	//Not needed with custom read/write functions: png_init_io(png_ptr, fp);
-	png_set_IHDR(png_ptr, info_ptr, width, height, 8, PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
+	//row 'r' of the image, counting from the top:
+	auto row = [&](uint32_t r) {
+		if (origin == LowerLeftOrigin) r = height - 1 - r;
+		return reinterpret_cast< uint8_t const * >(data + size_t(r) * width);
+	};
 
-	png_write_info(png_ptr, info_ptr);
-	//png_set_swap_alpha(png_ptr) // might need?
-	vector< png_bytep > row_pointers(height);
-	for (unsigned int i = 0; i < height; ++i) {
-		if (origin == UpperLeftOrigin) {
-			row_pointers[i] = (png_bytep)&(data[i * width]);
+	//bands of about 256k of filtered data (plenty to compress well, and enough bands to share out a large image):
+	uint32_t band_rows = uint32_t(std::max< size_t >(1, (256 * 1024) / filtered_row_bytes));
+	uint32_t bands = (height + band_rows - 1) / band_rows;
+	auto for_each_band = [&](std::function< void(uint32_t) > const &fn) {
+		if (encoding.parallel) {
+			ThreadPool::shared().parallel_for(bands, fn);
 		} else {
-			row_pointers[i] = (png_bytep)&(data[(height - 1 - i) * width]);
+			for (uint32_t b = 0; b < bands; ++b) fn(b);
+		}
+	};
+
+	//(1) filter all the rows, and checksum each band:
+	vector< uint8_t > filtered(size_t(height) * filtered_row_bytes);
+	vector< uLong > band_adler(bands);
+	for_each_band([&](uint32_t b){
+		uint32_t end = std::min(height, (b + 1) * band_rows);
+		for (uint32_t r = b * band_rows; r < end; ++r) {
+			filter_row(encoding.filter, row(r), (r > 0 ? row(r-1) : nullptr), row_bytes, &filtered[r * filtered_row_bytes]);
 		}
+		size_t begin = size_t(b * band_rows) * filtered_row_bytes;
+		band_adler[b] = adler32(adler32(0L, Z_NULL, 0), &filtered[begin], uInt(size_t(end) * filtered_row_bytes - begin));
+	});
+	uLong adler = band_adler[0];
+	for (uint32_t b = 1; b < bands; ++b) {
+		uint32_t rows = std::min(height, (b + 1) * band_rows) - b * band_rows;
+		adler = adler32_combine(adler, band_adler[b], z_off_t(size_t(rows) * filtered_row_bytes));
 	}
-	png_write_image(png_ptr, &(row_pointers[0]));
 
-	png_write_end(png_ptr, info_ptr);
+	//(2) deflate each band into a complete IDAT chunk (the first one starts the zlib stream, the last one ends it):
+	vector< vector< uint8_t > > chunks(bands);
+	for_each_band([&](uint32_t b){
+		size_t begin = size_t(b * band_rows) * filtered_row_bytes;
+		size_t end = size_t(std::min(height, (b + 1) * band_rows)) * filtered_row_bytes;
+		bool first = (b == 0);
+		bool last = (b + 1 == bands);
 
-	png_destroy_write_struct(&png_ptr, &info_ptr);
+		z_stream z;
+		std::memset(&z, 0, sizeof(z));
+		//(-15: raw deflate, since the zlib header and trailer are added here; filtered data favors Z_FILTERED, as in libpng)
+		if (deflateInit2(&z, level, Z_DEFLATED, -15, 8, (encoding.filter == PNGFilterNone ? Z_DEFAULT_STRATEGY : Z_FILTERED)) != Z_OK) {
+			throw std::runtime_error("Failed to start deflate.");
+		}
+		if (!first) {
+			size_t dictionary = std::min< size_t >(32768, begin);
+			deflateSetDictionary(&z, &filtered[begin - dictionary], uInt(dictionary));
+		}
+
+		vector< uint8_t > &chunk = chunks[b];
+		size_t at = 8; //(length and type go first)
+		chunk.resize(at + 2 + deflateBound(&z, uLong(end - begin)) + 64);
+		std::memcpy(&chunk[4], "IDAT", 4);
+		if (first) {
+			//zlib header: 32k window deflate, with a hint of the level:
+			uint32_t cmf = 0x78;
+			uint32_t flg = (level < 2 ? 0 : (level < 6 ? 1 : (level == 6 ? 2 : 3))) << 6;
+			flg += 31 - ((cmf * 256 + flg) % 31);
+			chunk[at++] = uint8_t(cmf);
+			chunk[at++] = uint8_t(flg);
+		}
+
+		z.next_in = &filtered[begin];
+		z.avail_in = uInt(end - begin);
+		while (true) {
+			z.next_out = &chunk[at];
+			z.avail_out = uInt(chunk.size() - at);
+			int ret = deflate(&z, (last ? Z_FINISH : Z_SYNC_FLUSH));
+			at = chunk.size() - z.avail_out;
+			if (ret == Z_STREAM_ERROR) {
+				deflateEnd(&z);
+				throw std::runtime_error("Failed to deflate.");
+			}
+			if (last ? ret == Z_STREAM_END : (z.avail_in == 0 && z.avail_out != 0)) break;
+			chunk.resize(chunk.size() * 2);
+		}
+		deflateEnd(&z);
+
+		chunk.resize(at + (last ? 4 : 0) + 4);
+		if (last) {
+			put_u32(&chunk[at], uint32_t(adler));
+			at += 4;
+		}
+		put_u32(&chunk[0], uint32_t(at - 8));
+		put_u32(&chunk[at], uint32_t(crc32(crc32(0L, Z_NULL, 0), &chunk[4], uInt(at - 4))));
+	});
+
+	//(3) write the file:
+	auto write_chunk = [&to](char const *type, uint8_t const *chunk_data, uint32_t length) {
+		uint8_t header[8];
+		put_u32(header, length);
+		std::memcpy(header + 4, type, 4);
+		uLong crc = crc32(crc32(0L, Z_NULL, 0), header + 4, 4);
+		if (length) crc = crc32(crc, chunk_data, length);
+		uint8_t footer[4];
+		put_u32(footer, uint32_t(crc));
+		to.write(reinterpret_cast< char const * >(header), 8);
+		to.write(reinterpret_cast< char const * >(chunk_data), length);
+		to.write(reinterpret_cast< char const * >(footer), 4);
+	};
 
-	return;
+	static uint8_t const signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	to.write(reinterpret_cast< char const * >(signature), 8);
+
+	uint8_t ihdr[13];
+	put_u32(ihdr + 0, width);
+	put_u32(ihdr + 4, height);
+	ihdr[8] = 8; //bit depth
+	ihdr[9] = 6; //color type: RGBA
+	ihdr[10] = 0; //compression: deflate
+	ihdr[11] = 0; //filter method: adaptive (per-row filter types)
+	ihdr[12] = 0; //no interlace
+	write_chunk("IHDR", ihdr, 13);
+
+	for (auto const &chunk : chunks) {
+		to.write(reinterpret_cast< char const * >(chunk.data()), chunk.size());
+	}
+
+	write_chunk("IEND", nullptr, 0);
+
+	if (!to.flush()) {
+		LOG_ERROR("Error writing png.");
+	}
 }
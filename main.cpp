@@ -8,17 +8,31 @@
 #include "GL.hpp"
 
 //for screenshots:
-#include "load_save_png.hpp"
+#include "FrameCapture.hpp"
+
+//for checking that frames don't allocate:
+#include "allocation_count.hpp"
+
+//for timing where frame time goes:
+#include "FrameStats.hpp"
+
+//for turning off the shader program cache:
+#include "gl_compile_program.hpp"
+
+//for editing shaders while the game runs:
+#include "ShaderReloader.hpp"
 
 //Includes for libSDL:
 #include <SDL.h>
 
 //...and for c++ standard library functions:
 #include <chrono>
+#include <string>
 #include <iostream>
 #include <stdexcept>
 #include <memory>
 #include <algorithm>
+#include <utility>
 
 int main(int argc, char **argv) {
 #ifdef _WIN32
@@ -26,6 +40,58 @@ int main(int argc, char **argv) {
 	try {
 #endif
 
+	//------------  command line ------------
+
+	//usage: pong [--tick-rate <hz>] [--frame-csv <file.csv>] [--frame-trace <file.json>] [--record <prefix>]
+	//   [--capture <prefix> | --capture-raw <file>] [--capture-every <n>] [--no-program-cache] [--shaders <dir>]
+	//   [--check-allocations]
+	// --tick-rate updates in fixed steps of 1/hz seconds (default 120), or once per frame with the frame's time if 0
+	// --frame-csv, --frame-trace write per-frame timings (see FrameStats.hpp) to these files on exit
+	// --record writes each game's input to <prefix>-<game>.pongrec (see Replay.hpp; replay with pong-sim --replay)
+	// --capture saves frames from the start as <prefix>000000.png, ...; --capture-raw appends them to one raw RGBA file
+	// --capture-every captures only every n-th frame (default 1); F6 starts/stops capturing (see FrameCapture.hpp)
+	// --no-program-cache always compiles shader programs instead of loading saved binaries (see gl_compile_program.hpp)
+	// --shaders builds shader programs from source files in <dir> (written there on first run), and rebuilds them when those change
+	// --check-allocations exits with an error if update + draw allocate once a game has warmed up (see allocation_count.hpp)
+	float tick_rate = 120.0f;
+	std::string frame_csv, frame_trace, record_prefix;
+	std::string capture_target = "capture-";
+	FrameCapture::Format capture_format = FrameCapture::PNGSequence;
+	uint32_t capture_every = 1;
+	bool capture_at_start = false;
+	std::string shader_directory;
+	bool check_allocations = false;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--tick-rate" && i + 1 < argc) {
+			tick_rate = std::stof(argv[++i]);
+			if (!(tick_rate >= 0.0f)) throw std::runtime_error("Tick rate can't be negative.");
+		} else if (arg == "--frame-csv" && i + 1 < argc) {
+			frame_csv = argv[++i];
+		} else if (arg == "--frame-trace" && i + 1 < argc) {
+			frame_trace = argv[++i];
+		} else if (arg == "--record" && i + 1 < argc) {
+			record_prefix = argv[++i];
+		} else if ((arg == "--capture" || arg == "--capture-raw") && i + 1 < argc) {
+			capture_target = argv[++i];
+			capture_format = (arg == "--capture-raw" ? FrameCapture::RawRGBA : FrameCapture::PNGSequence);
+			capture_at_start = true;
+		} else if (arg == "--capture-every" && i + 1 < argc) {
+			int every = std::stoi(argv[++i]);
+			if (every < 1) throw std::runtime_error("Capture interval must be at least one frame.");
+			capture_every = uint32_t(every);
+		} else if (arg == "--no-program-cache") {
+			gl_program_cache_directory = "";
+		} else if (arg == "--shaders" && i + 1 < argc) {
+			shader_directory = argv[++i];
+		} else if (arg == "--check-allocations") {
+			check_allocations = true;
+		} else {
+			std::cerr << "Usage:\n\t" << argv[0] << " [--tick-rate <hz>] [--frame-csv <file.csv>] [--frame-trace <file.json>] [--record <prefix>]\n\t\t[--capture <prefix> | --capture-raw <file>] [--capture-every <n>] [--no-program-cache] [--shaders <dir>]\n\t\t[--check-allocations]" << std::endl;
+			return 1;
+		}
+	}
+
 	//------------  initialization ------------
 
 	//Initialize SDL library:
@@ -86,8 +152,34 @@ int main(int argc, char **argv) {
 	//Hide mouse cursor (note: showing can be useful for debugging):
 	//SDL_ShowCursor(SDL_DISABLE);
 
+	//shader source files to watch, if asked for:
+	// (created before any programs, so they register with it; reset before the context goes away)
+	std::unique_ptr< ShaderReloader > shader_reloader;
+	if (shader_directory != "") {
+		shader_reloader.reset(new ShaderReloader(shader_directory));
+		ShaderReloader::current = shader_reloader.get();
+	}
+
+	//start building the first game's shader programs now, so they compile while the rest of startup runs:
+	// (after the shader reloader, which decides where program sources are read from)
+	auto programs_started = std::chrono::high_resolution_clock::now();
+	PongMode::Programs first_programs = PongMode::start_programs();
+
 	//------------ create game mode + make current --------------
-	Mode::set_current(std::make_shared< PongMode >());
+
+	//starts a game with 'programs' (recorded, if asked for):
+	uint32_t games_started = 0;
+	auto new_game = [&](PongMode::Programs &&programs) {
+		games_started += 1;
+		std::string record_to;
+		if (record_prefix != "") {
+			record_to = record_prefix + "-" + std::to_string(games_started) + ".pongrec";
+			std::cout << "Recording game to '" << record_to << "'." << std::endl;
+		}
+		return std::make_shared< PongMode >(std::move(programs), record_to);
+	};
+
+	//(the first game is started at the end of setup, below, once its programs have had time to build)
 
 	//------------ main loop ------------
 
@@ -106,12 +198,55 @@ int main(int argc, char **argv) {
 	};
 	on_resize();
 
+	//press F3 to print heap allocations made by update + draw once a second:
+	// (should be zero once the game has warmed up, except for the frame where a new game starts;
+	//  --check-allocations makes any other allocation an error)
+	bool report_allocations = false;
+	uint64_t report_frames = 0;
+	uint64_t report_allocated = 0;
+	auto report_before = std::chrono::high_resolution_clock::now();
+	//frames drawn since the current game started (allocations are allowed while this is under WarmupFrames):
+	constexpr uint64_t WarmupFrames = 60;
+	uint64_t warm_frames = 0;
+
+	//per-phase CPU times and GPU draw time of every frame:
+	// (created now that there is a context; reset before the context goes away)
+	std::unique_ptr< FrameStats > frame_stats(new FrameStats());
+
+	//screenshots and captured frames are read back and saved in the background:
+	// (created now that there is a context; reset before the context goes away)
+	std::unique_ptr< FrameCapture > frame_capture(new FrameCapture());
+	if (capture_at_start) {
+		frame_capture->start_capture(capture_target, capture_format, capture_every);
+	}
+
+	//press F4 to print frame time percentiles once a second:
+	bool report_frame_times = false;
+	auto frame_times_before = std::chrono::high_resolution_clock::now();
+
+	//with a fixed timestep, time that has passed but not yet been run as a whole tick:
+	float tick_accumulator = 0.0f;
+
+	//frames that took too long to run all of (see "spiral of death" below), and the game time they dropped:
+	uint64_t slow_frames = 0;
+	double skipped_time = 0.0;
+
+	//start the first game, waiting for whatever is left of building its programs:
+	{
+		auto setup_done = std::chrono::high_resolution_clock::now();
+		Mode::set_current(new_game(std::move(first_programs)));
+		auto ready = std::chrono::high_resolution_clock::now();
+		std::cout << "Startup: first game ready " << std::chrono::duration< double, std::milli >(ready - programs_started).count() << " ms after starting its shader programs"
+			<< " (" << std::chrono::duration< double, std::milli >(setup_done - programs_started).count() << " ms of other setup ran meanwhile)." << std::endl;
+	}
+
 	//This will loop until the current mode is set to null:
 	while (Mode::current) {
 		//every pass through the game loop creates one frame of output
 		//  by performing three steps:
 
 		{ //(1) process any events that are pending
+			FrameStats::Scope timer(*frame_stats, FrameStats::Events);
 			static SDL_Event evt;
 			while (SDL_PollEvent(&evt) == 1) {
 				//handle resizing:
@@ -124,6 +259,22 @@ int main(int argc, char **argv) {
 				} else if (evt.type == SDL_QUIT) {
 					Mode::set_current(nullptr);
 					break;
+				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_F3) {
+					report_allocations = !report_allocations;
+					report_frames = 0;
+					report_allocated = 0;
+					report_before = std::chrono::high_resolution_clock::now();
+				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_F4) {
+					report_frame_times = !report_frame_times;
+					frame_times_before = std::chrono::high_resolution_clock::now();
+				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_F6) {
+					if (frame_capture->capturing()) {
+						frame_capture->stop_capture();
+					} else try {
+						frame_capture->start_capture(capture_target, capture_format, capture_every);
+					} catch (std::exception const &e) {
+						std::cerr << "Failed to start capture: " << e.what() << std::endl;
+					}
 				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_PRINTSCREEN) {
 					// --- screenshot key ---
 					std::string filename = "screenshot.png";
@@ -132,48 +283,144 @@ int main(int argc, char **argv) {
 					glReadBuffer(GL_FRONT);
 					int w,h;
 					SDL_GL_GetDrawableSize(window, &w, &h);
-					std::vector< glm::u8vec4 > data(w*h);
-					glReadPixels(0,0,w,h, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
-					for (auto &px : data) {
-						px.a = 0xff;
-					}
-					save_png(filename, glm::uvec2(w,h), data.data(), LowerLeftOrigin);
+					//(read back and saved over the next few frames; see FrameCapture.hpp)
+					frame_capture->request(filename, glm::uvec2(w,h));
 				}
 			}
 			if (!Mode::current) break;
+
+			//rebuild shaders whose files changed; swap in ones that finished rebuilding:
+			if (shader_reloader) shader_reloader->update();
 		}
 
+		uint64_t allocations_before = thread_allocation_count();
+
 		{ //(2) call the current mode's "update" function to deal with elapsed time:
+			FrameStats::Scope timer(*frame_stats, FrameStats::Update);
 			auto current_time = std::chrono::high_resolution_clock::now();
 			static auto previous_time = current_time;
 			float elapsed = std::chrono::duration< float >(current_time - previous_time).count();
 			previous_time = current_time;
 
+			//runs one update; returns false if that finished the game (and so started a new one):
+			auto update = [&](float dt) {
+				Mode::current->update(dt);
+				if (!Mode::current->curGameState()) {
+					//(replacing the shared_ptr destroys the finished game)
+					Mode::set_current(new_game(PongMode::start_programs()));
+					warm_frames = 0;
+					assert(Mode::current);
+					return false;
+				}
+				return true;
+			};
+
 			//if frames are taking a very long time to process,
 			//lag to avoid spiral of death:
-			elapsed = std::min(0.1f, elapsed);
+			// (fixed ticks can catch up on a little more, since each tick stays short; a variable step is the whole frame)
+			float const max_elapsed = (tick_rate > 0.0f ? 0.25f : 0.1f);
+			if (elapsed > max_elapsed) {
+				if (slow_frames == 0) {
+					std::cerr << "NOTE: frame took " << elapsed << " seconds; skipping " << (elapsed - max_elapsed) << " seconds of game time"
+						<< " (further slow frames are counted and reported on exit)." << std::endl;
+				}
+				slow_frames += 1;
+				skipped_time += elapsed - max_elapsed;
+				elapsed = max_elapsed;
+			}
 
-			Mode::current->update(elapsed);
-			if (!Mode::current->curGameState()) {
-				Mode::current->~Mode();
-				Mode::set_current(std::make_shared< PongMode >());
-				assert(Mode::current);
+			if (tick_rate > 0.0f) {
+				//fixed timestep: run as many whole ticks as have built up (maybe none) and carry the rest to the next frame,
+				// so the game plays the same at any frame rate:
+				float const tick = 1.0f / tick_rate;
+				tick_accumulator += elapsed;
+				while (tick_accumulator >= tick) {
+					tick_accumulator -= tick;
+					if (!update(tick)) {
+						tick_accumulator = 0.0f; //(new game starts fresh)
+						break;
+					}
+				}
+				Mode::current->update_alpha = tick_accumulator / tick;
+			} else {
+				//variable timestep: one update per frame, covering the whole frame:
+				update(elapsed);
+				Mode::current->update_alpha = 1.0f;
 			}
 			if (!Mode::current) break;
 		}
 
 		{ //(3) call the current mode's "draw" function to produce output:
-		
+			FrameStats::Scope timer(*frame_stats, FrameStats::Draw);
+			frame_stats->begin_gpu();
 			Mode::current->draw(drawable_size);
+			frame_stats->end_gpu();
+		}
+
+		//heap allocations made by update + draw:
+		uint64_t frame_allocations = thread_allocation_count() - allocations_before;
+		if (check_allocations && warm_frames >= WarmupFrames && frame_allocations != 0) {
+			throw std::runtime_error("Frame " + std::to_string(warm_frames) + " of a game made " + std::to_string(frame_allocations) + " heap allocations in update + draw (--check-allocations).");
+		}
+		warm_frames += 1;
+
+		//capture the frame just drawn, if capturing:
+		if (frame_capture->capturing()) {
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+			glReadBuffer(GL_BACK);
+			frame_capture->capture_frame(drawable_size);
+		}
+
+		if (report_allocations) {
+			report_allocated += frame_allocations;
+			report_frames += 1;
+			auto now = std::chrono::high_resolution_clock::now();
+			if (std::chrono::duration< float >(now - report_before).count() >= 1.0f) {
+				std::cout << "heap allocations: " << double(report_allocated) / double(report_frames) << " per frame"
+					<< " (" << report_frames << " frames)" << std::endl;
+				report_frames = 0;
+				report_allocated = 0;
+				report_before = now;
+			}
+		}
+
+		{ //Wait until the recently-drawn frame is shown before doing it all again:
+			FrameStats::Scope timer(*frame_stats, FrameStats::Swap);
+			SDL_GL_SwapWindow(window);
 		}
 
-		//Wait until the recently-drawn frame is shown before doing it all again:
-		SDL_GL_SwapWindow(window);
+		frame_stats->end_frame();
+
+		//move any screenshots / captured frames along:
+		frame_capture->poll();
+
+		if (report_frame_times) {
+			auto now = std::chrono::high_resolution_clock::now();
+			if (std::chrono::duration< float >(now - frame_times_before).count() >= 1.0f) {
+				frame_stats->print(std::cout);
+				frame_times_before = now;
+			}
+		}
 	}
 
 
 	//------------  teardown ------------
 
+	if (slow_frames > 0) {
+		std::cerr << "NOTE: " << slow_frames << " slow frames skipped " << skipped_time << " seconds of game time in all." << std::endl;
+	}
+	if (frame_csv != "") {
+		std::cout << "Writing frame times to '" << frame_csv << "'." << std::endl;
+		frame_stats->write_csv(frame_csv);
+	}
+	if (frame_trace != "") {
+		std::cout << "Writing frame trace to '" << frame_trace << "'." << std::endl;
+		frame_stats->write_trace(frame_trace);
+	}
+	frame_stats.reset();
+	frame_capture.reset(); //(waits for any screenshots or captured frames to finish saving)
+	shader_reloader.reset();
+
 	SDL_GL_DeleteContext(context);
 	context = 0;
 
@@ -0,0 +1,691 @@
+//PongSim runs the game without a window or OpenGL context:
+#include "PongSim.hpp"
+
+//PongBatch runs many of them at once:
+#include "PongBatch.hpp"
+
+//stepping should never touch the heap; count to check:
+#include "allocation_count.hpp"
+
+//for re-running recorded games:
+#include "Replay.hpp"
+
+//for checking the overlap kernel:
+#include "aabb.hpp"
+
+//for timing asset loading:
+#include "PNGLoadBatch.hpp"
+#include "ThreadPool.hpp"
+
+//for checking the texture cache:
+#include "TextureCache.hpp"
+
+//...and for c++ standard library functions:
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+//scripted "player": follow the ball with a slowly wandering offset so hits vary:
+static float scripted_offset(uint64_t tick) {
+	return 0.8f * std::sin(float(tick) * 0.013f);
+}
+
+//Re-runs recorded games (see Replay.hpp) and checks each ends in the recorded state;
+// returns the number of logs that didn't:
+static int check_replays(int count, char **filenames) {
+	int failed = 0;
+	for (int i = 0; i < count; ++i) {
+		std::string filename = filenames[i];
+		ReplayLog log = load_replay(filename);
+
+		auto before = std::chrono::high_resolution_clock::now();
+		PongSim sim = run_replay(log);
+		auto after = std::chrono::high_resolution_clock::now();
+		double seconds = std::chrono::duration< double >(after - before).count();
+
+		std::cout << filename << ": " << log.updates.size() << " updates (seed " << log.seed << ") in " << seconds << " seconds; "
+			<< "score " << sim.left_score << ", lives " << sim.left_lives << ": ";
+		if (!log.has_hash) {
+			std::cout << "no final state recorded (recording didn't finish), not checked." << std::endl;
+		} else if (sim.state_hash() == log.state_hash) {
+			std::cout << "matches." << std::endl;
+		} else {
+			std::cout << "MISMATCH (state hash " << std::hex << sim.state_hash() << ", recorded " << log.state_hash << std::dec << ")." << std::endl;
+			failed += 1;
+		}
+	}
+	return failed;
+}
+
+//The overlap tests collide() used before aabb_overlap_mask() replaced them, copied verbatim from the old
+// gateCollide and paddle_vs_ball lambdas (paddle_vs_ball up to its "no overlap" early return, which now reports the answer):
+struct OldOverlapTests : PongSim {
+	using PongSim::PongSim;
+	enum : int { MOVING_PAD = 0, STATIONARY_PAD = 1 };
+
+	//Sees purely if there is an overlap, ie collision, between balls and both gates
+	bool gateCollide() const {
+		//After
+		//Top
+		glm::vec2 radius = topRadius;
+		glm::vec2 min = glm::max(topCenter - radius, ball - ball_radius);
+		glm::vec2 max = glm::min(topCenter + radius, ball + ball_radius);
+		if (!(min.x > max.x || min.y > max.y)) return true;
+		//Bottom
+		radius = bottomRadius;
+		min = glm::max(bottomCenter - radius, ball - ball_radius);
+		max = glm::min(bottomCenter + radius, ball + ball_radius);
+		if (!(min.x > max.x || min.y > max.y)) return true;
+		//Before
+		//Top
+		radius = topRadiusB;
+		min = glm::max(topCenterB - radius, ball - ball_radius);
+		max = glm::min(topCenterB + radius, ball + ball_radius);
+		if (!(min.x > max.x || min.y > max.y) && useEarlier) return true;
+		//Bottom
+		radius = bottomRadiusB;
+		min = glm::max(bottomCenterB - radius, ball - ball_radius);
+		max = glm::min(bottomCenterB + radius, ball + ball_radius);
+		if (!(min.x > max.x || min.y > max.y) && useEarlier) return true;
+		return false;
+	}
+
+	//paddles:
+	bool paddle_vs_ball(glm::vec2 const &paddle, int whichPad) const {
+		//compute area of overlap:
+		glm::vec2 radius = paddle_radius;
+		if (whichPad == STATIONARY_PAD) radius = block_radius;
+		glm::vec2 min = glm::max(paddle - radius, ball - ball_radius);
+		glm::vec2 max = glm::min(paddle + radius, ball + ball_radius);
+
+		//if no overlap, no collision:
+		if (min.x > max.x || min.y > max.y) return false;
+		return true;
+	}
+};
+
+//Checks PongSim::overlap_mask() (and so aabb_overlap_mask()) against the old tests, with the ball at random
+// spots and then exactly touching (and one float step either side of) each edge and corner of every box;
+// returns the number of mismatches:
+static uint64_t check_overlap(uint64_t cases, uint64_t seed) {
+	Pcg32 rng(seed);
+	uint64_t checked = 0;
+	uint64_t failed = 0;
+
+	auto check = [&](OldOverlapTests const &sim) {
+		uint32_t mask = sim.overlap_mask();
+		uint32_t gates = (1u << PongSim::TopGateBox) | (1u << PongSim::BottomGateBox);
+		if (sim.useEarlier) gates |= (1u << PongSim::TopGateBBox) | (1u << PongSim::BottomGateBBox);
+		bool ok = true;
+		ok = ok && (((mask & gates) != 0) == sim.gateCollide());
+		ok = ok && (((mask >> PongSim::PaddleBox) & 1) == sim.paddle_vs_ball(sim.left_paddle, OldOverlapTests::MOVING_PAD));
+		ok = ok && (((mask >> PongSim::TopBlockBox) & 1) == sim.paddle_vs_ball(sim.topBlock, OldOverlapTests::STATIONARY_PAD));
+		ok = ok && (((mask >> PongSim::BottomBlockBox) & 1) == sim.paddle_vs_ball(sim.bottomBlock, OldOverlapTests::STATIONARY_PAD));
+		checked += 1;
+		if (!ok) {
+			if (failed < 10) {
+				std::cout << "  MISMATCH: ball (" << sim.ball.x << ", " << sim.ball.y << "), mask " << std::hex << mask << std::dec
+					<< ", score " << sim.left_score << ", paddle y " << sim.left_paddle.y << std::endl;
+			}
+			failed += 1;
+		}
+	};
+
+	auto before = std::chrono::high_resolution_clock::now();
+
+	for (uint64_t c = 0; c < cases; ++c) {
+		//a game somewhere in its first 30 levels, with the paddle and blocks anywhere:
+		OldOverlapTests sim(rng.next());
+		sim.left_score = rng.next() % (30 * sim.levelPoints);
+		sim.left_paddle.y = rng.range(-sim.court_radius.y, sim.court_radius.y);
+		sim.newGate(sim.left_score);
+		sim.topBlock.y = rng.range(-sim.court_radius.y, sim.court_radius.y);
+		sim.bottomBlock.y = rng.range(-sim.court_radius.y, sim.court_radius.y);
+
+		//random spots (a little past the court, too):
+		for (uint32_t i = 0; i < 16; ++i) {
+			sim.ball.x = rng.range(-1.1f, 1.1f) * sim.court_radius.x;
+			sim.ball.y = rng.range(-1.1f, 1.1f) * sim.court_radius.y;
+			check(sim);
+		}
+
+		//touching each box's edges and corners:
+		glm::vec2 const centers[] = { sim.left_paddle, sim.topBlock, sim.bottomBlock, sim.topCenter, sim.bottomCenter, sim.topCenterB, sim.bottomCenterB };
+		glm::vec2 const radii[] = { sim.paddle_radius, sim.block_radius, sim.block_radius, sim.topRadius, sim.bottomRadius, sim.topRadiusB, sim.bottomRadiusB };
+		static_assert(sizeof(centers) / sizeof(centers[0]) == PongSim::BoxCount, "one entry per box");
+		for (uint32_t b = 0; b < PongSim::BoxCount; ++b) {
+			for (int sx = -1; sx <= 1; ++sx) {
+				for (int sy = -1; sy <= 1; ++sy) {
+					if (sx == 0 && sy == 0) continue;
+					glm::vec2 at = centers[b] + glm::vec2(float(sx), float(sy)) * (radii[b] + sim.ball_radius);
+					//(on edges, slide along the edge so the other axis is inside the box)
+					if (sx == 0) at.x += rng.range(-radii[b].x, radii[b].x);
+					if (sy == 0) at.y += rng.range(-radii[b].y, radii[b].y);
+					for (int nx = -1; nx <= 1; ++nx) {
+						for (int ny = -1; ny <= 1; ++ny) {
+							sim.ball.x = (nx == 0 ? at.x : std::nextafter(at.x, nx * std::numeric_limits< float >::infinity()));
+							sim.ball.y = (ny == 0 ? at.y : std::nextafter(at.y, ny * std::numeric_limits< float >::infinity()));
+							check(sim);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	auto after = std::chrono::high_resolution_clock::now();
+	double seconds = std::chrono::duration< double >(after - before).count();
+	std::cout << "overlap self-check (" << aabb_kernel_name() << " kernel): " << checked << " ball positions in " << seconds << " seconds; "
+		<< failed << " mismatches against the old overlap tests." << std::endl;
+	return failed;
+}
+
+//The gate sampler newGate() used before it drew from the allowed range directly, copied verbatim
+// (it re-ran all of newGate -- up to ten times, by recursion -- whenever the gap landed on the paddle):
+struct OldGates : PongSim {
+	using PongSim::PongSim;
+	int recurLimit = 0;
+	enum : int { TOO_CLOSE = 2 }; //(as #defined in PongSim.cpp)
+
+	void newGate(unsigned int points) {
+
+		//Setting level and gap params
+		unsigned int level = (points / levelPoints % 10) + 1; //In game level (goes up to 10)
+		if (points / levelPoints >= 10) useEarlier = true;
+		if (points / levelPoints >= 20) moveBlocks = true;
+		if(points / levelPoints >= 20) bottomBlock.x = newRightBlock.x;
+		float ratio = (maxGap - minGap) / 10.f; //How much to decreases size per level
+		float curGap = maxGap - (float) level * ratio; //Update gap and cap at min (level 10 +)
+		if (curGap <= minGap) curGap = minGap; 
+
+		//Generating random gate (all draws come from the game's rng, so gates follow from the seed)
+		float curTop = rng.range(0.0f, maxTop - (curGap + minBottom)) + curGap + minBottom; //Randomly make new gate (top of gate gap)
+		
+		//This lambda creates a new gate top for the before gate based on the after gate's top.
+		//@return - float, the percentage of the screen's y that the before gate's top is at
+		//@param - curTop - after gate's top in percentage, curGap - what percentage of the screen's y the gap should take
+		auto givenBackTop = [this](float curTop, float curGap) {
+			//seedRes is intended to give a range of feasible but dynamic offsets for the before gap compared to after gap
+			float seedRes = rng.range(1.5f, 3.0f);
+
+			//See if putting gap above or below after goes out of bounds. If so, don't use
+			//Above gap is - yDivX ration * the x offset + a randomized 1/seedRes fraction of curGap above the after's gap
+			//Bottom is similar but below instead of above
+			bool justBottom = false;
+			float beforeUp = curTop + yDivXOffset * defXOffset + curGap/seedRes;
+			if (beforeUp >= maxTop + 0.03333) justBottom = true; //Error to make edge cases feasible without limiting the possible places for second gate
+			bool justTop = false;
+			float beforeDown = curTop - yDivXOffset * defXOffset - curGap/seedRes;
+			if (beforeDown - curGap <= minBottom) justTop = true;
+
+			assert(justTop || beforeDown >= minBottom + curGap);
+			assert(beforeUp >= minBottom + curGap);
+			if (justBottom)return beforeDown;
+			if (justTop) return beforeUp;
+
+			//If both are possible, do a coin flip to decide if to do above or below
+			assert(beforeDown >= minBottom + curGap && beforeUp >= minBottom + curGap && beforeUp > beforeDown);
+			if(rng.unit() >= 0.5f) return beforeDown;
+			return beforeUp;
+		};
+
+		//Creating gate coordinates
+		topRadius = glm::vec2(gateWidth, (1.0f - curTop) * court_radius.y + minBottom / 2); 
+		bottomRadius = glm::vec2(gateWidth, (curTop - curGap) * court_radius.y);
+		float topY = ((1.0f - curTop)/2 + curTop) * 2 * court_radius.y - court_radius.y;
+		topCenter = glm::vec2(gateX, topY);
+		float bottomY = bottomRadius.y - court_radius.y;
+		bottomCenter = glm::vec2(gateX, bottomY);
+		assert(bottomY - bottomRadius.y <= -0.499*court_radius.y);
+
+		//Creating earlier gate coordinates based off of first gate coordinates
+		float curTopB = givenBackTop(curTop, curGap);
+		assert(curTopB - curGap >= minBottom - 0.0005f);
+		//Creating actual coordinates based on new top
+		topRadiusB = glm::vec2(gateWidth, (1.0f - curTopB) * court_radius.y + minBottom / 2);
+		bottomRadiusB = glm::vec2(gateWidth, (curTopB - curGap) * court_radius.y);
+		float topYB = ((1.0f - curTopB) / 2 + curTopB) * 2 * court_radius.y - court_radius.y;
+		topCenterB = glm::vec2(gateX - defXOffset*2*court_radius.x - 2 *gateWidth, topYB);
+		float bottomYB = bottomRadiusB.y - court_radius.y;
+		bottomCenterB = glm::vec2(gateX - defXOffset * 2 * court_radius.x - 2 * gateWidth, bottomYB);
+		assert(bottomYB - bottomRadiusB.y <= -0.499 * court_radius.y);
+		assert(topYB > bottomYB);
+		if (useEarlier) { //Make sure gap isn't right where player is to avoid cheating
+			if (recurLimit < 10 && std::abs(curTopB - curGap / 2 - left_paddle.y) <= curGap / TOO_CLOSE) {
+				recurLimit++;
+				newGate(left_score);
+			}
+		}
+		else {
+			if (recurLimit < 10 && std::abs(curTop - curGap / 2 - left_paddle.y) <= curGap / TOO_CLOSE) {
+				recurLimit++;
+				newGate(left_score);
+			}
+		}
+		recurLimit = 0; //Avoid infinite recursion
+	}
+};
+
+//Plays games that start far past the last level (where the ball speeds up every few points) at steps from
+// PongSim::Tick up to PongSim::MaxStep, and checks the ball stays finite and inside the court and no motion is dropped;
+// returns the number of runs where it didn't:
+static uint32_t check_high_scores(uint64_t seed) {
+	uint32_t failed = 0;
+	for (uint32_t levels : { 40u, 100u, 1000u, 100000u }) {
+		for (float tick : { PongSim::Tick, 0.05f, PongSim::MaxStep }) {
+			PongSim sim(seed);
+			sim.left_score = levels * sim.levelPoints;
+			sim.newGate(sim.left_score);
+			uint32_t start_score = sim.left_score;
+			uint32_t start_lives = sim.left_lives;
+
+			uint64_t const ticks = uint64_t(600.0f / tick); //ten minutes of play
+			uint64_t t = 0;
+			bool ok = true;
+			for (; t < ticks && sim.gameState && ok; ++t) {
+				sim.left_paddle.y = sim.ball.y + scripted_offset(t);
+				sim.update(tick);
+				ok = std::isfinite(sim.ball.x) && std::isfinite(sim.ball.y)
+					&& std::abs(sim.ball.x) <= sim.court_radius.x && std::abs(sim.ball.y) <= sim.court_radius.y
+					&& sim.dropped_steps == 0;
+			}
+
+			std::cout << "  from score " << start_score << " at " << tick << " second steps: speed multiplier " << sim.speed_multiplier()
+				<< ", " << (sim.left_score - start_score) << " points and " << (start_lives - sim.left_lives) << " lives lost in " << t << " steps; "
+				<< "ball at (" << sim.ball.x << ", " << sim.ball.y << ")";
+			if (ok) {
+				std::cout << "." << std::endl;
+			} else {
+				std::cout << (sim.dropped_steps ? " -- DROPPED MOTION." : " -- LEFT THE COURT.") << std::endl;
+				failed += 1;
+			}
+		}
+	}
+	std::cout << "high score self-check: " << failed << " runs with the ball outside the court or motion dropped." << std::endl;
+	return failed;
+}
+
+//Plays the same games through PongSim and PongBatch side by side at tick lengths from PongSim::Tick past
+// PongSim::MaxStep, and checks every game's state hash matches after every step (so the batch's lanes bounce
+// the ball bit-for-bit as PongSim::sweep() does); returns the number of tick lengths where a game didn't match:
+static uint32_t check_batch(uint64_t seed) {
+	uint32_t const count = 256;
+	uint32_t failed = 0;
+	for (float tick : { PongSim::Tick, 0.05f, PongSim::MaxStep, 0.25f, 2.0f }) {
+		uint64_t const ticks = std::max< uint64_t >(100, uint64_t(60.0f / tick)); //a minute of play (or 100 ticks)
+
+		std::vector< PongSim > sims;
+		sims.reserve(count);
+		for (uint32_t i = 0; i < count; ++i) {
+			sims.emplace_back(seed + i);
+		}
+		PongBatch batch(count, seed);
+		uint64_t next_sim_seed = seed + count, next_batch_seed = seed + count;
+
+		uint64_t mismatches = 0;
+		uint64_t const contacts_before = batch.lane_contacts, swept_before = batch.swept;
+		for (uint64_t t = 0; t < ticks && mismatches == 0; ++t) {
+			float offset = scripted_offset(t);
+			for (uint32_t i = 0; i < count; ++i) {
+				sims[i].left_paddle.y = sims[i].ball.y + offset;
+				sims[i].update(tick);
+				if (!sims[i].gameState) sims[i] = PongSim(next_sim_seed++);
+
+				batch.paddle_y[i] = batch.ball_y[i] + offset;
+			}
+			batch.step(tick);
+			for (uint32_t i : batch.finished) {
+				batch.reset(i, next_batch_seed++);
+			}
+			for (uint32_t i = 0; i < count; ++i) {
+				if (batch.sync(i).state_hash() != sims[i].state_hash()) mismatches += 1;
+			}
+		}
+
+		std::cout << "  " << tick << " second steps: " << (batch.lane_contacts - contacts_before) << " contacts in lanes, "
+			<< (batch.swept - swept_before) << " steps through PongSim";
+		if (mismatches == 0) {
+			std::cout << "." << std::endl;
+		} else {
+			std::cout << " -- " << mismatches << " GAMES DIFFER FROM PONGSIM." << std::endl;
+			failed += 1;
+		}
+	}
+	std::cout << "batch self-check: " << failed << " tick lengths where PongBatch and PongSim disagree." << std::endl;
+	return failed;
+}
+
+//Decodes 'filenames' one after another with load_png, then all at once with PNGLoadBatch, and reports both times;
+// returns the number of images that failed to load or came back different from the batch:
+static uint32_t time_png_loads(std::vector< std::string > const &filenames) {
+	uint32_t failed = 0;
+
+	//one after another, on this thread:
+	std::vector< glm::uvec2 > sizes(filenames.size(), glm::uvec2(0));
+	std::vector< std::vector< glm::u8vec4 > > images(filenames.size());
+	size_t bytes = 0;
+	auto before = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < filenames.size(); ++i) {
+		try {
+			load_png(filenames[i], &sizes[i], &images[i], LowerLeftOrigin);
+			bytes += images[i].size() * sizeof(glm::u8vec4);
+		} catch (std::exception const &e) {
+			std::cout << "  " << filenames[i] << ": " << e.what() << std::endl;
+			failed += 1;
+		}
+	}
+	auto after = std::chrono::high_resolution_clock::now();
+	double serial = std::chrono::duration< double >(after - before).count();
+
+	//all at once, on ThreadPool::shared():
+	ThreadPool::shared(); //(started first, so its threads aren't part of the timing)
+	uint32_t mismatched = 0;
+	before = std::chrono::high_resolution_clock::now();
+	{
+		PNGLoadBatch batch(filenames, LowerLeftOrigin);
+		batch.wait([&](PNGLoadBatch::Image &image){
+			if (image.error != "") return; //(counted above)
+			if (image.size != sizes[image.index] || image.data != images[image.index]) mismatched += 1;
+		});
+	}
+	after = std::chrono::high_resolution_clock::now();
+	double batched = std::chrono::duration< double >(after - before).count();
+
+	std::cout << "load_png: " << filenames.size() << " images (" << (bytes / (1024.0 * 1024.0)) << " MB decoded) in " << serial << " seconds." << std::endl;
+	std::cout << "PNGLoadBatch (" << ThreadPool::shared().size() << " workers): " << batched << " seconds; "
+		<< (serial / batched) << "x; " << mismatched << " images differ from load_png's." << std::endl;
+	return failed + mismatched;
+}
+
+//Checks TextureCache's lookups in a scratch cache directory, without OpenGL (fetch() is all of load() but the upload):
+// - the first fetch of an image misses, and builds a mip chain down to 1x1 that starts with the decoded image;
+// - the next fetch hits, and maps the same bytes back;
+// - a damaged entry is rebuilt (a miss), and then hits again;
+// - loading with the other origin makes a separate entry.
+//Returns the number of failed checks:
+static uint32_t check_texture_cache(std::vector< std::string > const &pngs) {
+	std::string const directory = "texture-cache-check";
+	TextureCache cache(directory, false);
+	std::vector< std::string > entries; //(removed afterward)
+	uint32_t failed = 0;
+	auto expect = [&failed](bool ok, std::string const &png, char const *what) {
+		if (!ok) {
+			std::cout << "  " << png << ": " << what << std::endl;
+			failed += 1;
+		}
+	};
+	auto bytes_of = [](TextureCache::Entry const &entry) {
+		std::vector< uint8_t > bytes;
+		for (auto const &level : entry.levels) {
+			bytes.insert(bytes.end(), level.data, level.data + level.bytes);
+		}
+		return bytes;
+	};
+
+	for (auto const &png : pngs) {
+		glm::uvec2 size;
+		std::vector< glm::u8vec4 > image;
+		load_png(png, &size, &image, LowerLeftOrigin);
+
+		uint32_t hits = cache.hits, misses = cache.misses;
+		TextureCache::Entry cold = cache.fetch(png);
+		if (std::find(entries.begin(), entries.end(), cold.filename) != entries.end()) {
+			std::cout << "  " << png << ": same image as an earlier file; skipped." << std::endl;
+			continue;
+		}
+		entries.emplace_back(cold.filename);
+		expect(cache.misses == misses + 1 && cache.hits == hits && !cold.mapped, png, "first fetch wasn't a miss");
+
+		bool chain = !cold.levels.empty() && cold.levels[0].size == size && cold.levels.back().size == glm::uvec2(1);
+		for (uint32_t i = 1; chain && i < cold.levels.size(); ++i) {
+			chain = (cold.levels[i].size == glm::max(glm::uvec2(1), cold.levels[i-1].size / 2u));
+		}
+		expect(chain, png, "levels don't halve from the image's size down to 1x1");
+		expect(!cold.levels.empty() && cold.levels[0].bytes == image.size() * sizeof(glm::u8vec4)
+			&& std::memcmp(cold.levels[0].data, image.data(), cold.levels[0].bytes) == 0, png, "first level isn't the decoded image");
+
+		std::vector< uint8_t > built = bytes_of(cold);
+		{
+			TextureCache::Entry warm = cache.fetch(png);
+			expect(cache.hits == hits + 1 && warm.mapped && warm.filename == cold.filename, png, "second fetch wasn't a hit");
+			expect(bytes_of(warm) == built, png, "cached levels differ from the ones built");
+		}
+
+		//cut the entry short; it should be rebuilt (and then found):
+		std::ofstream(cold.filename, std::ios::binary | std::ios::trunc).write("texcach1", 8);
+		{
+			TextureCache::Entry rebuilt = cache.fetch(png);
+			expect(cache.misses == misses + 2 && !rebuilt.mapped && bytes_of(rebuilt) == built, png, "damaged entry wasn't rebuilt");
+			TextureCache::Entry warm = cache.fetch(png);
+			expect(cache.hits == hits + 2 && warm.mapped, png, "rebuilt entry wasn't a hit");
+		}
+
+		TextureCache::Entry flipped = cache.fetch(png, UpperLeftOrigin);
+		entries.emplace_back(flipped.filename);
+		expect(cache.misses == misses + 3 && flipped.filename != cold.filename, png, "other origin didn't make its own entry");
+	}
+
+	std::cout << "texture cache self-check: " << cache.hits << " hits, " << cache.misses << " misses over "
+		<< pngs.size() << " images; " << failed << " failed checks." << std::endl;
+
+	for (auto const &entry : entries) {
+		std::remove(entry.c_str());
+	}
+	std::remove(directory.c_str()); //(removes the then-empty directory, where the platform's remove() does that)
+	return failed;
+}
+
+//Totals from stepping a set of games for a while:
+struct Run {
+	double seconds = 0.0;
+	uint64_t games = 0; //games finished
+	uint64_t points = 0; //points scored (in finished and unfinished games)
+	uint64_t allocations = 0; //heap allocations while stepping
+	uint64_t swept = 0; //game ticks stepped by PongSim::sweep() inside PongBatch (PongBatch runs only)
+	uint64_t dropped_steps = 0; //steps that ran into PongSim::SweepLimit (only possible past PongSim::MaxStep)
+	double dropped_time = 0.0; //...and the seconds of ball motion they dropped
+	void add_dropped(PongSim const &sim) {
+		dropped_steps += sim.dropped_steps;
+		dropped_time += sim.dropped_time;
+	}
+};
+
+//'count' games at once, as one PongSim per game updated one after the other, for 'ticks' ticks of 'tick' seconds:
+// (games are seeded seed, seed+1, ... in the order they start)
+static Run run_sims(uint64_t ticks, uint32_t count, float tick, uint64_t seed) {
+	Run run;
+
+	auto before = std::chrono::high_resolution_clock::now();
+
+	std::vector< PongSim > sims;
+	sims.reserve(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		sims.emplace_back(seed + i);
+	}
+	uint64_t next_seed = seed + count;
+	uint64_t allocations_before = allocation_count();
+	for (uint64_t t = 0; t < ticks; ++t) {
+		float offset = scripted_offset(t);
+		for (auto &sim : sims) {
+			sim.left_paddle.y = sim.ball.y + offset;
+			sim.update(tick);
+			if (!sim.gameState) {
+				run.points += sim.left_score;
+				run.games += 1;
+				run.add_dropped(sim);
+				sim = PongSim(next_seed++);
+			}
+		}
+	}
+	run.allocations = allocation_count() - allocations_before;
+	for (auto const &sim : sims) {
+		run.points += sim.left_score;
+		run.add_dropped(sim);
+	}
+
+	auto after = std::chrono::high_resolution_clock::now();
+	run.seconds = std::chrono::duration< double >(after - before).count();
+	return run;
+}
+
+//...the same games, all in one PongBatch:
+static Run run_batch(uint64_t ticks, uint32_t count, float tick, uint64_t seed) {
+	Run run;
+
+	auto before = std::chrono::high_resolution_clock::now();
+
+	PongBatch batch(count, seed);
+	uint64_t next_seed = seed + count;
+	uint64_t allocations_before = allocation_count();
+	for (uint64_t t = 0; t < ticks; ++t) {
+		float offset = scripted_offset(t);
+		for (uint32_t i = 0; i < count; ++i) {
+			batch.paddle_y[i] = batch.ball_y[i] + offset;
+		}
+		batch.step(tick);
+		for (uint32_t i : batch.finished) {
+			run.points += batch.games[i].left_score;
+			run.games += 1;
+			run.add_dropped(batch.games[i]);
+			batch.reset(i, next_seed++);
+		}
+	}
+	run.allocations = allocation_count() - allocations_before;
+	for (auto const &sim : batch.games) {
+		run.points += sim.left_score;
+		run.add_dropped(sim);
+	}
+	run.swept = batch.swept;
+
+	auto after = std::chrono::high_resolution_clock::now();
+	run.seconds = std::chrono::duration< double >(after - before).count();
+	return run;
+}
+
+//Headless driver: steps games at a fixed timestep as fast as possible and reports throughput.
+// usage: pong-sim [ticks per game] [games] [seconds per tick] [seed]
+// (with more than one game, runs the same workload through PongSim and PongBatch and compares,
+//  then compares them again at a few tick lengths, since PongBatch gains less the longer ticks are)
+// (games are seeded seed, seed+1, ... in the order they start, so both runs play exactly the same games)
+// (tick length defaults to PongSim::Tick; the ball is swept, so it can't pass through anything at any tick length,
+//  but ticks longer than PongSim::MaxStep (0.1 seconds) may drop motion after PongSim::SweepLimit contacts -- reported if so)
+// (then times newGate() on its own)
+//   or: pong-sim --replay <file.pongrec> [...]
+// (re-runs recorded games and checks them; exits non-zero on any mismatch)
+//   or: pong-sim --load-pngs <file.png> [...]
+// (times decoding the images one at a time with load_png against PNGLoadBatch; exits non-zero if any fail or differ)
+//   or: pong-sim --texture-cache-check <file.png> [...]
+// (checks TextureCache hits, misses, and rebuilds in a scratch directory, without OpenGL; exits non-zero on any failure)
+//   or: pong-sim --self-check [games] [seed]
+// (checks the vectorized overlap tests against the scalar ones they replaced, that the ball stays
+//  in the court at very high scores, and that PongBatch steps games exactly as PongSim does; exits non-zero on any failure)
+int main(int argc, char **argv) {
+	if (argc > 1 && std::string(argv[1]) == "--replay") {
+		return (check_replays(argc - 2, argv + 2) == 0 ? 0 : 1);
+	}
+	if (argc > 1 && std::string(argv[1]) == "--load-pngs") {
+		return (time_png_loads(std::vector< std::string >(argv + 2, argv + argc)) == 0 ? 0 : 1);
+	}
+	if (argc > 1 && std::string(argv[1]) == "--texture-cache-check") {
+		return (check_texture_cache(std::vector< std::string >(argv + 2, argv + argc)) == 0 ? 0 : 1);
+	}
+	if (argc > 1 && std::string(argv[1]) == "--self-check") {
+		uint64_t cases = 100000;
+		if (argc > 2) cases = std::stoull(argv[2]);
+		uint64_t seed = 1;
+		if (argc > 3) seed = std::stoull(argv[3]);
+		uint64_t failed = check_overlap(cases, seed);
+		failed += check_high_scores(seed);
+		failed += check_batch(seed);
+		return (failed == 0 ? 0 : 1);
+	}
+
+	uint64_t ticks = 1000000;
+	uint32_t count = 1;
+	if (argc > 1) ticks = std::stoull(argv[1]);
+	if (argc > 2) count = uint32_t(std::stoul(argv[2]));
+	float tick = PongSim::Tick;
+	if (argc > 3) tick = std::stof(argv[3]);
+	uint64_t seed = 1;
+	if (argc > 4) seed = std::stoull(argv[4]);
+	if (!(tick > 0.0f)) throw std::runtime_error("Tick length must be positive.");
+	if (count == 0) throw std::runtime_error("Need at least one game.");
+
+	auto report = [&](char const *name, Run const &run) {
+		double game_ticks = double(ticks) * double(count);
+		std::cout << name << ": " << game_ticks << " game ticks (" << (game_ticks * tick) << " game seconds) in " << run.seconds << " seconds." << std::endl;
+		std::cout << "  " << (game_ticks / run.seconds) << " game ticks/second; " << run.games << " games finished, " << run.points << " points scored." << std::endl;
+		std::cout << "  " << run.allocations << " heap allocations while stepping." << std::endl;
+		if (run.dropped_steps) {
+			std::cout << "  " << run.dropped_steps << " ticks ran into PongSim::SweepLimit and dropped " << run.dropped_time << " seconds of ball motion"
+				<< " (ticks are longer than PongSim::MaxStep)." << std::endl;
+		}
+		return game_ticks / run.seconds;
+	};
+
+	double scalar_rate = report("PongSim", run_sims(ticks, count, tick, seed));
+
+	if (count > 1) {
+		Run batch = run_batch(ticks, count, tick, seed);
+		double batch_rate = report("PongBatch", batch);
+		std::cout << "  " << (100.0 * double(batch.swept) / (double(ticks) * double(count))) << "% of game ticks went through the scalar PongSim::sweep()." << std::endl;
+		std::cout << "PongBatch / PongSim throughput: " << (batch_rate / scalar_rate) << "x" << std::endl;
+
+		//longer steps mean more contacts per step, and more of them scoring (which PongSim finishes; see PongBatch.hpp),
+		// so show how the speedup falls off as steps get longer:
+		// (ticks past PongSim::MaxStep are outside what PongSim promises to step correctly; dropped motion is shown for those)
+		uint64_t const short_ticks = std::max< uint64_t >(1, ticks / 4);
+		std::cout << "PongBatch / PongSim throughput by tick length (" << short_ticks << " ticks of " << count << " games each):" << std::endl;
+		for (float length : { PongSim::Tick, 0.05f, PongSim::MaxStep, 0.25f, 2.0f }) {
+			Run sims = run_sims(short_ticks, count, length, seed);
+			Run batch = run_batch(short_ticks, count, length, seed);
+			std::cout << "  " << length << " seconds: " << (sims.seconds / batch.seconds) << "x, "
+				<< (100.0 * double(batch.swept) / (double(short_ticks) * double(count))) << "% swept by PongSim";
+			if (length > PongSim::MaxStep) {
+				std::cout << " (past PongSim::MaxStep: " << sims.dropped_steps << " ticks dropped " << sims.dropped_time << " seconds of motion)";
+			}
+			std::cout << "." << std::endl;
+		}
+	}
+
+	{ //gate generation on its own (runs on every point and lost life), against the old retrying sampler:
+		uint64_t const calls = 1000000;
+
+		//calls/second of 'sim.newGate', walking through every level with the paddle all over the court
+		// (with 'inside', the paddle stays where the gap test can hit it -- y in [0.1,0.9], since that test compares
+		//  the gap's top as a fraction of the court with the paddle's y in court units -- so the old sampler retries more):
+		auto time_gates = [&](auto &sim, bool inside) {
+			float check = 0.0f; //(so the calls can't be optimized away)
+			auto before = std::chrono::high_resolution_clock::now();
+			for (uint64_t c = 0; c < calls; ++c) {
+				sim.left_score = uint32_t(c % (30 * sim.levelPoints));
+				sim.left_paddle.y = (inside ? 0.5f + 0.5f * scripted_offset(c) : sim.court_radius.y * scripted_offset(c));
+				sim.newGate(sim.left_score);
+				check += sim.topCenterB.y;
+			}
+			auto after = std::chrono::high_resolution_clock::now();
+			if (check != check) std::cout << "(NaN gate)" << std::endl;
+			return double(calls) / std::chrono::duration< double >(after - before).count();
+		};
+
+		for (bool inside : { false, true }) {
+			OldGates old_sim(seed);
+			PongSim sim(seed);
+			double old_rate = time_gates(old_sim, inside);
+			double rate = time_gates(sim, inside);
+			std::cout << "newGate" << (inside ? " (paddle where the gap test can hit it)" : "") << ": " << rate << " calls/second, "
+				<< "old retrying sampler " << old_rate << " calls/second (" << (rate / old_rate) << "x)." << std::endl;
+		}
+	}
+
+	return 0;
+}